@@ -42,7 +42,42 @@
  
  Exception handling by the framework can be disabled, to trace the source of an exception in your debugger for example. You just need to declare the 
  compilation constant DO_NOT_USE_EXCEPTIONS to do so. You may also disable catching the system exceptions (also known as signals) by declaring the constant
- DO_NOT_CATCH_SIGNALS.
+ DO_NOT_CATCH_SIGNALS. On POSIX systems a test that crashes, for example with an invalid memory access or a stack overflow, is reported as failed
+ and the run goes on (see ntk::TestSignals), even when exceptions are disabled.
+ 
+ Tests may be run in parallel on a pool of worker threads using Test::runAll(result, jobs). Test suites that must not run concurrently with other tests
+ can be declared using the SERIAL_SUITE and SERIAL_SUBSUITE macros. Thread support can be disabled by declaring the compilation constant DO_NOT_USE_THREADS,
+ in which case all tests are run serially. The results may also be reported from a background thread (see ntk::AsyncTestResult), so that a slow
+ report does not slow down the tests.
+ 
+ On POSIX systems, tests may also be isolated in child processes (see ntk::TestOptions), so that a crashing test is reported as a failure instead of 
+ stopping the whole run. Process support can be disabled by declaring the compilation constant DO_NOT_USE_PROCESSES.
+ 
+ A maximum running time can be set for each test using the TEST_TIMEOUT macro, or for all tests using ntk::TestOptions. A test running for too long is
+ aborted if tests are isolated in child processes, otherwise the run is stopped after reporting the test failure and a partial summary.
+ 
+ The assertion macros stop the test at the first failed check, while the soft checks of the TE_CHECK macros report their failures and let the test
+ go on, up to a limit set in ntk::TestOptions. The checks can also be profiled (see ntk::TestCheckProfile), to find the assertions that slow
+ down the tests.
+ 
+ The heap allocations of each test can be counted by replacing the global operator new and delete with the TRACK_ALLOCATIONS macro, they are then 
+ reported by TestResult::allocationResult() and can be checked with T_CHECK_MAX_ALLOCS. Each test also has a scratch memory arena (see Test::arena()).
+ 
+ On Linux, the hardware performance counters (cycles, instructions, cache and branch misses) of each test and benchmark can be read as well (see 
+ ntk::TestCounters), they are then reported by TestResult::counterResult(). Counters support can be disabled by declaring the compilation constant 
+ DO_NOT_USE_PERF_COUNTERS.
+ 
+ The samples of the benchmarks can be written to a file of JSON lines and compared by a later run (see ntk::TestBenchmarkSamples): the change of 
+ each benchmark is printed with its confidence interval, and the benchmarks significantly slower than the allowed regression fail, making the 
+ run a performance gate.
+ 
+ Tests declared with the macros are registered in a static table of constant descriptors, so no code is run and no memory is allocated at startup: 
+ test objects are only created when the tests are first run, and listing the tests only creates the parameterized tests to find their batches. 
+ With GCC or Clang on ELF systems the table is built by the linker, elsewhere (or if the compilation constant DO_NOT_USE_TEST_SECTION is declared)
+ each descriptor is linked in a list by a trivial static initializer.
+ The bookkeeping of the framework is kept small for suites of hundreds of thousands of cases: the names given by the macros are not copied, the
+ records of a test share its interned path (see TestResult::timings()) and the copies of the failures share interned file and test names (see 
+ ntk::TestStrings).
  
  Even though it is part of the NTK, it does not rely on any NTK classes (in fact was aimed to be a testing framework to test the NTK classes).
  This framework is compiler-agnostic and based on the standard C++ library.  
@@ -86,10 +121,67 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <fstream>
 #include <vector>
 #include <limits>
 #include <ctime>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+#include <set>
+#include <map>
+#include <list>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <random>
+
+#ifndef DO_NOT_USE_THREADS
+#   include <thread>
+#   include <mutex>
+#   include <condition_variable>
+#   include <deque>
+#   include <cstdlib>
+#endif
+
+#if defined (__GNUC__) || defined (__clang__)
+#   define __T_NOINLINE __attribute__((noinline))
+#elif defined (_MSC_VER)
+#   define __T_NOINLINE __declspec(noinline)
+#else
+#   define __T_NOINLINE
+#endif
+
+#if !defined (DO_NOT_USE_TEST_SECTION) && (defined (__GNUC__) || defined (__clang__)) && defined (__ELF__)
+#   define __T_USE_TEST_SECTION
+#endif
+
+#if !defined (DO_NOT_USE_PROCESSES) && (defined (__unix__) || defined (__APPLE__))
+#   define __T_USE_PROCESSES
+#   include <deque>
+#   include <cstdio>
+#   include <cstdlib>
+#   include <cstring>
+#   include <cerrno>
+#   include <csignal>
+#   include <unistd.h>
+#   include <poll.h>
+#   include <sys/wait.h>
+#endif
+
+#if !defined (DO_NOT_USE_PERF_COUNTERS) && defined (__linux__)
+#   define __T_USE_PERF_COUNTERS
+#   include <unistd.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#endif
 
 #ifndef DO_NOT_USE_EXCEPTIONS
 #   include <exception>
@@ -98,434 +190,1024 @@
 #   endif
 #endif
 
+#ifdef __linux__
+#   include <sched.h>
+#endif
+
+#if !defined (DO_NOT_CATCH_SIGNALS) && (defined (__unix__) || defined (__APPLE__))
+#   define __T_USE_SIGNAL_RECOVERY
+#   include <csignal>
+#   include <setjmp.h>
+#   include <cstring>
+#endif
+
 namespace ntk {
     
 #pragma mark -
 #pragma mark Test types
     
-    /** Defines constant for the different test types. */
-    namespace TestType {
-        const std::string TestCase = "TestCase";        ///< Test case type (a simple test).
-        const std::string TestSuite = "TestSuite";      ///< Test suite type (a group of tests).
-    }
-    
-#pragma mark -
-#pragma mark Test definition
-    
-    class TestResult;
-    class TestFailure;
-    
     /**
-     Test is a base class for all tests. It provides method for running individual tests (runTest) as well as data members for recording the name and type of
-     the test. The type of test may be used in a ntk::TestResult class for processing differently differents test types (for example test case, test 
-     suites, etc).
-     
-     A test class is automatically registred in a global test set so you can use the static method Test::run() to run all tests at once.
-     Tests may be constructed and organized using the TEST, FIXTURE, SUITE and SUBSUITE macros, provided for convenience.
-     
-     @see ntk::TestSuite
-     @see ntk::TestFixture
-     @see ntk::TestResult
-     @see ntk::TestType
+     A TestType identifies the type of a test by an integer tag, so that types are copied and compared without any string operation. The types of the
+     framework are the constants of TestType::Id, other types may be declared by their name with TestType::named(). The name of a type is only used
+     for reporting.
      */
-    class Test {
+    class TestType {
     public:
         
-        /** 
-         Creates a new test with the specified name and type. 
-         The test may be specified to automatically register itself in the global test set (disabled by default).
-         */
-        Test(const std::string& name, const std::string& type = TestType::TestCase, bool autoRegisterTest = false) 
-        : mName(name), mType(type)
-        { if (autoRegisterTest) registerTest(this); }
+        /** The types of tests of the framework. */
+        enum Id {
+            TestCase,   ///< Test case type (a simple test).
+            TestSuite,  ///< Test suite type (a group of tests).
+            Benchmark,  ///< Benchmark type (a test measuring the performance of some code).
+            TestBatch   ///< Batch type (a group of cases of a parameterized test, only reported as its cases).
+        };
         
-        /** Destroys the test. */
-        virtual ~Test() {}
+        /** Creates the type with the specified id. */
+        TestType(Id id) : mId(id) {}
         
         /**
-         Runs the test, using the specified Test::Result object to process the test results.
-         Do not override this method to implement the test code, the method runTest() should be used instead.
-         This method should be overriden with great care as it all the necessary calls to enable fixture support, exception handling and result commits.
+         Gets the type with the specified name, declaring it the first time. The name must have a static lifetime (a string literal for example).
+         Types should be declared before the tests are run, for example when they are created, as the declared types are not synchronized.
          */
-        virtual int run(TestResult& result); // implemented later because of TestFailure and TestResult dependencies
+        static TestType named(const char* name) {
+            std::vector<const char*>& names = mNames();
+            size_t index = 0;
+            while ((index < names.size()) && (std::strcmp(names[index], name) != 0))
+                ++index;
+            if (index == names.size())
+                names.push_back(name);
+            return TestType((unsigned int)index);
+        }
         
-        /** Gets the type of the test. */
-        const std::string& type() const { return mType; }
+        /** Gets the name of the type. */
+        const char* name() const { return mNames()[mId]; }
         
-        /** Gets the name of the test. */
-        const std::string& name() const { return mName; }
+        /** Returns true if both types are the same. */
+        friend bool operator==(TestType a, TestType b) { return a.mId == b.mId; }
         
-        /** Runs all the tests, using the specified TestResult object to process the test results. */
-        static int runAll(TestResult& result); // implemented later because of TestResult dependency
+        /** Returns true if the types are different. */
+        friend bool operator!=(TestType a, TestType b) { return a.mId != b.mId; }
         
-    protected:
+    private:
+        explicit TestType(unsigned int index) : mId(index) {}
         
-        /** The method containing the actual test code, to be overriden. */
-        virtual void runTest(TestResult& result) = 0;
+        // the names of the types, indexed by id
+        static std::vector<const char*>& mNames() {
+            static std::vector<const char*> names = { "TestCase", "TestSuite", "Benchmark", "TestBatch" };
+            return names;
+        }
         
-    private:
-        static std::vector<Test*>& mTests() { static std::vector<Test*> tests; return tests; } // the list of all tests
-        static void registerTest(Test* test) { mTests().push_back(test); } // registers a new test in the global list (automatically done)
-
-        std::string mName;                  // the name of the test
-        std::string mType;                  // the type of the test
+        unsigned int mId;   // the index of the type
     };
     
 #pragma mark -
-#pragma mark Test suite definition
+#pragma mark Test timing
     
-    /**
-     A TestSuite is essentially a group of tests.
-     @see ntk::Test
+    /** Provides a monotonic high resolution clock, used for timing the tests. */
+    struct TestClock {
+        
+        /** Gets the current time in nanoseconds, from an arbitrary origin. */
+        static long long now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        
+        /** Converts the specified duration to nanoseconds. */
+        template <typename Rep, typename Period>
+        static long long nanoseconds(const std::chrono::duration<Rep, Period>& duration) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+        
+        /** Returns the specified duration, a number being considered as a duration in nanoseconds. */
+        static long long nanoseconds(long long duration) { return duration; }
+        
+        /** Returns a human readable string for the specified duration in nanoseconds, using the most appropriate unit. */
+        static std::string format(double duration) {
+            static const char* units[] = { "ns", "us", "ms", "s" };
+            double value = duration;
+            int unit = 0;
+            while ((unit < 3) && ((value >= 1000.0) || (value <= -1000.0))) {
+                value /= 1000.0;
+                ++unit;
+            }
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(((unit == 0) && (value == std::floor(value))) ? 0 : 3) << value << " " << units[unit];
+            return ss.str();
+        }
+    };
+    
+#pragma mark -
+#pragma mark Test options
+    
+    /** 
+     Defines the options used to run the tests. 
+     @see Test::runAll()
      */
-    class TestSuite : public Test 
-    {
-    public:
+    struct TestOptions {
         
-        /** 
-         Creates a new test suite with the specified name and type. 
-         The test suite may be specified to automatically register itself in the global test set (enabled by default).
-         */
-        TestSuite(const std::string& name, const std::string& type = TestType::TestSuite, bool autoRegisterTestGroup = true)
-        : Test(name, type, autoRegisterTestGroup)
-        {}
+        /** The test isolation modes. */
+        enum Isolation {
+            NoIsolation,    ///< Tests are run in the test process.
+            IsolateTests,   ///< Each test case is run in its own child process.
+            IsolateSuites   ///< The test cases of each suite are run together in a child process.
+        };
         
-        /** Destroys the test suite. */
-        virtual ~TestSuite() {}
+        /** The reports of the test results. */
+        enum Report {
+            DefaultReport,  ///< The results are processed by the result class given to RUN_TESTS.
+            TextReport,     ///< The results are written as indented text (see ntk::OStreamTestResult).
+            JUnitXmlReport, ///< The results are written in the JUnit XML format (see ntk::JUnitXmlTestResult).
+            JsonLinesReport ///< The results are written as JSON lines (see ntk::JsonLinesTestResult).
+        };
         
-        /** Adds a test to the test suite. */
-        void addTest(Test* test) { mTests.push_back(test); }
+        /** Creates the default options, optionally specifying the number of tests to run concurrently. */
+        TestOptions(unsigned int theJobs = 1)
+        : jobs(theJobs), isolation(NoIsolation), timeout(0), list(false), shardIndex(0), shardCount(1), failFast(false), report(DefaultReport), 
+          updateBaseline(false), benchmarkWarnings(true), maxRegression(10), counters(false), maxSoftFailures(100), profileChecks(false), 
+          shuffle(false), shuffleSeed(0), repeat(1), untilFail(false), asyncReport(false)
+        {}
         
         /**
-         Sets the current test suite.
-         If the test suite provided is NULL, returns the current test suite.
+         Sets the options from the specified command line arguments (as given to main()), returns false if an argument is invalid.
+         Errors and usage help are printed to the specified stream.
          */
-        static TestSuite* currentTestSuite(TestSuite* testSuite) {
-            // warning, default test suite won't be registered if a test suite is declared!
-            static TestSuite defaultTestSuite("DefaultTestSuite", TestType::TestSuite, (testSuite == NULL));
-            static TestSuite* currentSuite = &defaultTestSuite;
-            if (testSuite != NULL)
-                currentSuite = testSuite;
-            return currentSuite;
+        bool parse(int argc, char* argv[], std::ostream& os = std::cerr) {
+            // environment variables are overriden by command line arguments
+            const char* environmentShardIndex = std::getenv("NTK_TEST_SHARD_INDEX");
+            const char* environmentShardCount = std::getenv("NTK_TEST_SHARD_COUNT");
+            if ((environmentShardIndex != NULL) && isNumber(environmentShardIndex))
+                shardIndex = (unsigned int)std::strtoul(environmentShardIndex, NULL, 10);
+            if ((environmentShardCount != NULL) && isNumber(environmentShardCount))
+                shardCount = (unsigned int)std::strtoul(environmentShardCount, NULL, 10);
+            
+            bool repeatGiven = false;
+            for (int i = 1; i < argc; ++i) {
+                std::string arg = argv[i];
+                std::string value = (arg.find('=') == std::string::npos) ? "" : arg.substr(arg.find('=') + 1);
+                std::string name = arg.substr(0, arg.find('='));
+                
+                if ((name == "--help") || (name == "-h")) {
+                    usage(argv[0], os);
+                    return false;
+                } else if (name == "--list") {
+                    list = true;
+                } else if (name == "--filter") {
+                    split(value, filters);
+                } else if (name == "--exclude") {
+                    split(value, excludes);
+                } else if ((name == "--jobs") && isNumber(value)) {
+                    jobs = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--timeout") && isNumber(value)) {
+                    timeout = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--isolate") && ((value == "none") || (value == "tests") || (value == "suites"))) {
+                    isolation = (value == "tests") ? IsolateTests : ((value == "suites") ? IsolateSuites : NoIsolation);
+                } else if ((name == "--shard-index") && isNumber(value)) {
+                    shardIndex = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--shard-count") && isNumber(value)) {
+                    shardCount = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--changed-files") && !value.empty()) {
+                    changedFilesFile = value;
+                } else if ((name == "--dependencies") && !value.empty()) {
+                    dependenciesFile = value;
+                } else if ((name == "--durations") && !value.empty()) {
+                    durationsFile = value;
+                } else if ((name == "--fail-fast") && value.empty()) {
+                    failFast = true;
+                } else if (name == "--failed-first") {
+                    failuresFile = value.empty() ? ".ntk-unit-failures" : value;
+                } else if ((name == "--report") && ((value == "text") || (value == "junit") || (value == "jsonl"))) {
+                    report = (value == "junit") ? JUnitXmlReport : ((value == "jsonl") ? JsonLinesReport : TextReport);
+                } else if ((name == "--output") && !value.empty()) {
+                    outputFile = value;
+                } else if ((name == "--baseline") && !value.empty()) {
+                    baselineFile = value;
+                } else if ((name == "--update-baseline") && value.empty()) {
+                    updateBaseline = true;
+                } else if ((name == "--benchmark-output") && !value.empty()) {
+                    benchmarkFile = value;
+                } else if ((name == "--compare") && !value.empty()) {
+                    compareFile = value;
+                } else if ((name == "--no-benchmark-warnings") && value.empty()) {
+                    benchmarkWarnings = false;
+                } else if ((name == "--max-regression") && isNumber(value)) {
+                    maxRegression = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--counters") && value.empty()) {
+                    counters = true;
+                } else if ((name == "--max-soft-failures") && isNumber(value)) {
+                    maxSoftFailures = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--profile-checks") && value.empty()) {
+                    profileChecks = true;
+                } else if ((name == "--shuffle") && (value.empty() || isNumber(value))) {
+                    shuffle = true;
+                    shuffleSeed = value.empty() ? 0 : (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                } else if ((name == "--repeat") && isNumber(value) && (std::strtoul(value.c_str(), NULL, 10) > 0)) {
+                    repeat = (unsigned int)std::strtoul(value.c_str(), NULL, 10);
+                    repeatGiven = true;
+                } else if ((name == "--until-fail") && value.empty()) {
+                    untilFail = true;
+                } else if ((name == "--async-report") && value.empty()) {
+                    asyncReport = true;
+                } else {
+                    os << "Invalid argument: " << arg << std::endl;
+                    usage(argv[0], os);
+                    return false;
+                }
+            }
+            
+            if ((shardCount == 0) || (shardIndex >= shardCount)) {
+                os << "Invalid shard: index " << shardIndex << " of " << shardCount << " shards" << std::endl;
+                return false;
+            }
+            if (untilFail && !repeatGiven)
+                repeat = 0;     // no limit
+            return true;
         }
         
-    protected:
+        /** 
+         Returns true if the selected tests must be run again after the specified repetition (from 0), which had failures if failed is true.
+         The repetitions are stopped by a failure when repeating until a test fails or in fail fast mode.
+         */
+        bool repeatsAfter(unsigned int repetition, bool failed) const {
+            if (failed && (untilFail || failFast || (repeat == 0)))
+                return false;
+            return (repeat == 0) || (repetition + 1 < repeat);
+        }
         
-        /** The method containing the actual test code, to be overriden. */
-        virtual void runTest(TestResult& result) {
-            for (std::vector<Test*>::iterator it = mTests.begin(); it != mTests.end(); ++it)
-                (*it)->run(result);
+        /** Prints the command line usage help to the specified stream. */
+        static void usage(const std::string& program, std::ostream& os) {
+            os << "Usage: " << program << " [options]" << std::endl
+               << "  --filter=PATTERNS   only run the tests whose path matches one of the ':' separated patterns" << std::endl
+               << "  --exclude=PATTERNS  do not run the tests whose path matches one of the ':' separated patterns" << std::endl
+               << "  --list              list the selected tests without running them" << std::endl
+               << "  --changed-files=FILE  only run the tests affected by the files listed in FILE, one per line (git diff --name-only)" << std::endl
+               << "  --dependencies=FILE   the dependencies of the test files for --changed-files, as make rules (such as the files written by" << std::endl
+               << "                      the -MD option of the compiler)" << std::endl
+               << "  --jobs=N            run N tests concurrently, 0 for one per hardware thread" << std::endl
+               << "  --isolate=MODE      run each test (tests) or suite (suites) in a child process, or none" << std::endl
+               << "  --timeout=MS        fail the tests running for more than MS milliseconds" << std::endl
+               << "  --shard-count=N     split the selected tests in N shards (or use NTK_TEST_SHARD_COUNT)" << std::endl
+               << "  --shard-index=I     only run the tests of shard I, from 0 to N-1 (or use NTK_TEST_SHARD_INDEX)" << std::endl
+               << "  --durations=FILE    balance the shards and run the longest tests first using the test durations recorded in FILE," << std::endl
+               << "                      then record the new durations in FILE" << std::endl
+               << "  --fail-fast         stop running tests after the first failed test" << std::endl
+               << "  --failed-first[=FILE]  run the tests that failed during the last run first, then record the failed tests in FILE" << std::endl
+               << "                      (.ntk-unit-failures by default)" << std::endl
+               << "  --report=FORMAT     report the results as indented text (text), JUnit XML (junit) or JSON lines (jsonl)" << std::endl
+               << "  --output=FILE       write the report to FILE instead of the standard output" << std::endl
+               << "  --baseline=FILE     fail the benchmarks whose median regressed compared to the medians recorded in FILE" << std::endl
+               << "  --update-baseline   record the medians of the benchmarks run in the baseline file instead of checking them" << std::endl
+               << "  --benchmark-output=FILE  write the samples of the benchmarks run to FILE as JSON lines, to be compared by a later run" << std::endl
+               << "  --compare=FILE      compare the benchmarks to the samples written to FILE by --benchmark-output, failing the benchmarks whose" << std::endl
+               << "                      regression is significant and above the allowed regression, and print the differences" << std::endl
+               << "  --no-benchmark-warnings  do not warn about the CPU frequency scaling and pinning when benchmarks are written or compared" << std::endl
+               << "  --max-regression=PERCENT  the regression of a median allowed by the baseline or the comparison, 10% by default" << std::endl
+               << "  --counters          report the cycles, instructions, cache and branch misses of each test read from the hardware" << std::endl
+               << "                      performance counters (on Linux)" << std::endl
+               << "  --max-soft-failures=N  stop a test after N failed soft checks (TE_CHECK), 100 by default, 0 for no limit" << std::endl
+               << "  --profile-checks    count and time the checks of each assertion, reporting the slowest ones" << std::endl
+               << "  --shuffle[=SEED]    run the tests of each suite in a random order, from SEED or else from a seed printed on the standard error" << std::endl
+               << "  --repeat=N          run the selected tests N times" << std::endl
+               << "  --until-fail        repeat the selected tests until a test fails (at most N times with --repeat=N)" << std::endl
+               << "  --async-report      write the report from a background thread, so that a slow output does not slow down the tests" << std::endl
+               << "Test paths are made of the suite names and the test name separated by '/', for example Suite/SubSuite/Test. In patterns '*' matches" 
+               << std::endl << "any characters but '/', '**' any characters and '?' any single character. Matching a suite selects all its tests." << std::endl;
+        }
+        
+        unsigned int jobs;      ///< The number of tests run concurrently (1 to run serially, 0 for one per hardware thread).
+        Isolation isolation;    ///< The isolation mode, only supported on POSIX systems (tests are run in the test process otherwise).
+        unsigned int timeout;   ///< The default maximum time in milliseconds a test case may run, 0 for no timeout.
+        std::vector<std::string> filters;   ///< The patterns of tests to run, all tests are run if empty (see ntk::TestFilter).
+        std::vector<std::string> excludes;  ///< The patterns of tests not to run (see ntk::TestFilter).
+        bool list;              ///< True to list the selected tests instead of running them.
+        std::string changedFilesFile;   ///< The file listing the changed files, only the tests affected by them are run if not empty (see ntk::TestChanges).
+        std::string dependenciesFile;   ///< The dependencies of the files declaring the tests as make rules, used with the changed files if not empty.
+        unsigned int shardIndex;    ///< The index of the shard to run, from 0 to shardCount - 1.
+        unsigned int shardCount;    ///< The number of shards the selected tests are split in, 1 to run all the selected tests.
+        std::string durationsFile;  ///< The file caching the test durations between runs (see ntk::TestDurations), updated after each run.
+        bool failFast;              ///< True to stop running tests after the first test case that fails.
+        std::string failuresFile;   ///< The file caching the failed tests between runs (see ntk::TestFailures), run first and updated after each run.
+        Report report;              ///< The report of the results, used by Test::runAll() when no TestResult object is given.
+        std::string outputFile;     ///< The file the report is written to, the standard output if empty.
+        std::string baselineFile;   ///< The file recording the reference medians of the benchmarks (see ntk::TestBaseline), not used if empty.
+        bool updateBaseline;        ///< True to record the medians of the benchmarks in the baseline file, instead of checking them.
+        std::string benchmarkFile;  ///< The file the samples of the benchmarks are written to (see ntk::TestBenchmarkSamples), not written if empty.
+        std::string compareFile;    ///< The file of the samples of a previous run the benchmarks are compared to, not compared if empty.
+        bool benchmarkWarnings;     ///< True to warn about the CPU settings adding noise to the benchmarks when they are written or compared.
+        unsigned int maxRegression; ///< The regression of a benchmark median allowed by the baseline or by the comparison, in percent.
+        bool counters;              ///< True to read the hardware performance counters of the tests (see ntk::TestCounters).
+        unsigned int maxSoftFailures;   ///< The number of failed soft checks reported before a test is stopped (see TEM_CHECK), 0 for no limit.
+        bool profileChecks;         ///< True to count and time the checks of each assertion site (see ntk::TestCheckProfile).
+        bool shuffle;               ///< True to run the tests of each suite in a random order, shuffled again for each repetition.
+        unsigned int shuffleSeed;   ///< The seed of the shuffled order, 0 for a seed chosen by the run (and printed to the standard error).
+        unsigned int repeat;        ///< The number of times the selected tests are run, 0 for no limit (until a test fails).
+        bool untilFail;             ///< True to stop repeating the tests after a repetition where any test failed.
+        bool asyncReport;           ///< True to process the results on a background thread (see ntk::AsyncTestResult), if threads are supported.
+        
+    private:
+        // splits a ':' separated list of values
+        static void split(const std::string& values, std::vector<std::string>& result) {
+            std::istringstream ss(values);
+            std::string value;
+            while (std::getline(ss, value, ':'))
+                if (!value.empty())
+                    result.push_back(value);
         }
         
-        std::vector<Test*> mTests;  // the tests that are part of the group
+        // returns true if the value is a positive integer
+        static bool isNumber(const std::string& value) {
+            return !value.empty() && (value.find_first_not_of("0123456789") == std::string::npos);
+        }
     };
     
 #pragma mark -
-#pragma mark Fixture definition
+#pragma mark Test memory
     
     /**
-     A TestFixture is a basic class encapsulating a set of objects that serves as a base for a set of tests.
-     The setup/teardown mechanism of a fixture is implemented through the use use of standard c++ constructor and destructor.
-     You just have to declare a fixture class on the stack at the beginning of a test to use it.
-     
-     The convenience macros FIXTURE, SETUP, TEARDOWN and USE_FIXTURE are meant to simplify declaration and usage of test fixtures.
-     @see ntk::Test
+     A TestArena provides scratch memory to a test, for example to build failure messages, released all at once at the end of the test.
+     Memory is allocated in chunks directly from the system allocator, so it is not counted as allocations of the test (see ntk::TestAllocations).
+     Objects created in an arena are never destroyed, it should only be used for trivially destructible types.
      */
-    class TestFixture {
+    class TestArena {
     public:
         
-        /** Creates the fixture, used as the setup method of the fixture. */
-        TestFixture() {}
+        /** Creates an empty arena. */
+        TestArena() : mChunk(NULL), mUsed(0) {}
         
-        /** Destroys the fixture, used as the teardown method of the fixture. */
-        virtual ~TestFixture() = 0;
+        /** Destroys the arena, releasing all its memory. */
+        ~TestArena() { reset(); }
+        
+        /** Allocates the specified number of bytes with the specified alignment, which must be a power of 2. */
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+            size_t offset = (mChunk != NULL) ? align(mUsed, alignment) : 0;
+            if ((mChunk == NULL) || (offset + size > mChunk->size)) {
+                size_t chunkSize = std::max(size + alignment, (mChunk != NULL) ? (mChunk->size * 2) : (size_t)MinChunkSize);
+                Chunk* chunk = static_cast<Chunk*>(std::malloc(sizeof(Chunk) + chunkSize));
+                if (chunk == NULL) {
+#ifndef DO_NOT_USE_EXCEPTIONS
+                    throw std::bad_alloc();
+#else
+                    return NULL;
+#endif
+                }
+                chunk->previous = mChunk;
+                chunk->size = chunkSize;
+                mChunk = chunk;
+                mUsed = 0;
+                offset = align(0, alignment);
+            }
+            mUsed = offset + size;
+            return reinterpret_cast<char*>(mChunk + 1) + offset;
+        }
+        
+        /** Allocates an uninitialized array of the specified number of elements. */
+        template <typename T>
+        T* allocateArray(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+        
+        /** Copies the specified string in the arena. */
+        const char* copy(const char* text) {
+            size_t size = std::strlen(text) + 1;
+            return static_cast<const char*>(std::memcpy(allocate(size, 1), text, size));
+        }
+        
+        /** Copies the specified string in the arena. */
+        const char* copy(const std::string& text) { return copy(text.c_str()); }
+        
+        /** Releases all the memory of the arena. */
+        void reset() {
+            while (mChunk != NULL) {
+                Chunk* previous = mChunk->previous;
+                std::free(mChunk);
+                mChunk = previous;
+            }
+            mUsed = 0;
+        }
         
     private:
-        // private copy constructor and assign operator as a fixture must not be copied
-        TestFixture(const TestFixture&);
-        const TestFixture& operator=(const TestFixture&);
+        enum { MinChunkSize = 4096 };
+        
+        // a chunk of memory, followed by its data
+        struct Chunk {
+            Chunk* previous;    // the chunk allocated before
+            size_t size;        // the size of the data
+        };
+        
+        // gets the offset of the specified alignment following the specified offset in the current chunk
+        size_t align(size_t offset, size_t alignment) const {
+            uintptr_t address = reinterpret_cast<uintptr_t>(reinterpret_cast<char*>(mChunk + 1) + offset);
+            return offset + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+        }
+        
+        Chunk* mChunk;      // the last chunk allocated
+        size_t mUsed;       // the number of bytes used in the last chunk
+        
+        // private copy constructor and assign operator as an arena can't be copied
+        TestArena(const TestArena&);
+        const TestArena& operator=(const TestArena&);
     };
     
-    inline TestFixture::~TestFixture() {}   // pure virtual destructor implementation
-    
-#pragma mark -
-#pragma mark Test failure recording
-    
-    /**
-     A TestFailure object records the context information about a test failure.
-     C++ macros are used to provide the name of the file and the line number where the failure occurred.
-     */
-    class TestFailure {
-    public:
+    /** A TestAllocationStats object records the heap allocations made by a test. Sizes are expressed in bytes. */
+    struct TestAllocationStats {
         
-        /** Creates a new failure with the given context information. */
-        TestFailure(const std::string& theCondition, const std::string& theTestName, const std::string& TheFileName, int theLine)
-        : condition(theCondition), testName(theTestName), fileName(TheFileName), line(theLine)
+        /** Creates empty allocation statistics. */
+        TestAllocationStats()
+        : allocations(0), deallocations(0), bytes(0), peakBytes(0), retainedBytes(0), mPath("")
         {}
         
-        /** Stream output operator. */
-        friend std::ostream& operator<<(std::ostream& os, const TestFailure& failure) {
-            return (os << failure.fileName << "(" << failure.line << "): Failure: \"" << failure.condition << "\"");
-        }
+        /** Gets the path of the test (set by TestResult). */
+        std::string path() const { return mPath; }
         
-        std::string condition;  ///< The condition that provoked the failure.
-        std::string testName;   ///< The name of the test that failed.
-        std::string fileName;   ///< The name of the file in which the test failed.
-        int line;               ///< The line number at which the failure occured.
-    };        
-    
-#pragma mark -
-#pragma mark Test result processing
+        long long allocations;      ///< The number of allocations.
+        long long deallocations;    ///< The number of deallocations.
+        long long bytes;            ///< The number of bytes allocated.
+        long long peakBytes;        ///< The maximum amount of memory allocated by the test at the same time.
+        long long retainedBytes;    ///< The bytes allocated and not freed by the test (a potential leak), negative if it freed more than it allocated.
+        
+    private:
+        const char* mPath;          // the path of the test, interned for the whole run (see ntk::TestStrings)
+        friend class TestResult;    // sets the path
+    };
     
     /**
-     The TestResult class is used to process the test results.
-     By deriving from this class you can process these results by overriding methods that are called at various stages of the testing process.
-     This base class only provides global timing and records of executed tests and failures.
-     @see ntk::OStreamTestResult
+     TestAllocations counts the heap allocations made by each thread, when the global operator new and delete are replaced using the TRACK_ALLOCATIONS
+     macro. The allocations of each test case are then reported with TestResult::allocationResult(), and the T_CHECK_MAX_ALLOCS assertion can be used.
+     The allocations made to report test results are not counted.
      */
-    class TestResult {
+    class TestAllocations {
     public:
         
-        /** Creates a new test result. */
-        TestResult() 
-        : mTestCount(0), mFailureCount(0), mElapsedSeconds(0) 
-        {}
+        /** The allocation counters of a thread. */
+        struct Counters {
+            long long allocations;      ///< The number of allocations.
+            long long deallocations;    ///< The number of deallocations.
+            long long bytes;            ///< The number of bytes allocated.
+            long long liveBytes;        ///< The number of bytes allocated and not freed yet.
+            long long peakBytes;        ///< The maximum number of live bytes.
+            int paused;                 ///< The number of pauses in effect, allocations are not counted if positive.
+        };
         
-        /** Destroys the test result. */
-        virtual ~TestResult() {}
+        /** Pauses the counting of the allocations of the calling thread while it exists. */
+        class Pause {
+        public:
+            Pause() { ++counters().paused; }
+            ~Pause() { --counters().paused; }
+        };
         
-        /** This method is called before running all tests. */
-        virtual void allTestsBegin() {
-            ::time(&mStartTime);
-        }
+        /** Measures the allocations made by the calling thread in a block of code (see T_CHECK_MAX_ALLOCS). */
+        class Scope {
+        public:
+            /** Starts measuring, the scope must allow at most the specified number of allocations. */
+            Scope(long long maxAllocations) : mStart(counters()), mAllocations(0), mMaxAllocations(maxAllocations), mEnded(false) {}
+            
+            /** Stops measuring. */
+            void end() { mAllocations = counters().allocations - mStart.allocations; mEnded = true; }
+            
+            /** Returns true if the measures have been stopped. */
+            bool hasEnded() const { return mEnded; }
+            
+            /** Gets the number of allocations made in the scope. */
+            const long long& allocations() const { return mAllocations; }
+            
+            /** Gets the maximum number of allocations allowed in the scope. */
+            const long long& limit() const { return mMaxAllocations; }
+            
+        private:
+            Counters mStart;
+            long long mAllocations;
+            long long mMaxAllocations;
+            bool mEnded;
+        };
         
-        /** This method is called after all tests have been run. */
-        virtual void allTestsEnd() {
-            std::time_t endTime;
-            ::time(&endTime);
-            mElapsedSeconds = endTime - mStartTime;
+        /** Returns true if allocations are counted, i.e. the global operator new and delete have been replaced with TRACK_ALLOCATIONS. */
+        static bool isTracked() { return tracked().load(std::memory_order_relaxed); }
+        
+        /** Records that allocations are counted, called once at startup by the static initializer declared by TRACK_ALLOCATIONS. Returns true. */
+        static bool setTracked() { tracked().store(true, std::memory_order_relaxed); return true; }
+        
+        /** Gets the counters of the calling thread. */
+        static Counters& counters() {
+#ifndef DO_NOT_USE_THREADS
+            static thread_local Counters counters = {0, 0, 0, 0, 0, 0};
+#else
+            static Counters counters = {0, 0, 0, 0, 0, 0};
+#endif
+            return counters;
         }
         
-        /** This method is called each time a test begins. */
-        virtual void testBegins(Test* test) {
+        /** Starts measuring the allocations of a test on the calling thread. Returns the counters to give to statsSince() once the test is over. */
+        static Counters start() {
+            Counters& current = counters();
+            current.peakBytes = current.liveBytes;
+            return current;
         }
         
-        /** This method is called each time a test ends. */
-        virtual void testEnds(Test* test) {
-            if (test->type() == TestType::TestCase)
-                ++mTestCount;
+        /** 
+         Restores the counters of the calling thread as returned by start(), when a crashed test jumped over the end of its pauses (see ntk::TestSignals).
+         The allocations of the crashed test are forgotten, its memory being lost.
+         */
+        static void restore(const Counters& start) { counters() = start; }
+        
+        /** Gets the statistics of the allocations made since start() returned the specified counters. */
+        static TestAllocationStats statsSince(const Counters& start) {
+            const Counters& current = counters();
+            TestAllocationStats stats;
+            stats.allocations = current.allocations - start.allocations;
+            stats.deallocations = current.deallocations - start.deallocations;
+            stats.bytes = current.bytes - start.bytes;
+            stats.peakBytes = current.peakBytes - start.liveBytes;
+            stats.retainedBytes = current.liveBytes - start.liveBytes;
+            return stats;
         }
         
-        /** This method is called when a test has failed. */
-        virtual void addFailure(const TestFailure& failure) {
-            ++mFailureCount;
+        /** 
+         Allocates memory and counts the allocation, used by the operator new defined by TRACK_ALLOCATIONS. Returns NULL on failure.
+         The allocation functions are not inlined, otherwise the compiler would see the memory given by operator new freed with free().
+         */
+        static __T_NOINLINE void* allocate(size_t size) {
+            char* memory = static_cast<char*>(std::malloc(HeaderSize + size));
+            if (memory == NULL)
+                return NULL;
+            *reinterpret_cast<size_t*>(memory) = size;   // the size is stored before the memory given, to count the freed bytes
+            Counters& current = counters();
+            if (current.paused == 0) {
+                ++current.allocations;
+                current.bytes += size;
+                current.liveBytes += size;
+                current.peakBytes = std::max(current.peakBytes, current.liveBytes);
+            }
+            return memory + HeaderSize;
         }
         
-        /** Gets the number of test failures. */
-        int failures() const { return mFailureCount; }
+        /** Frees memory allocated with allocate() and counts the deallocation, used by the operator delete defined by TRACK_ALLOCATIONS. */
+        static __T_NOINLINE void deallocate(void* pointer) {
+            if (pointer == NULL)
+                return;
+            char* memory = static_cast<char*>(pointer) - HeaderSize;
+            Counters& current = counters();
+            if (current.paused == 0) {
+                ++current.deallocations;
+                current.liveBytes -= *reinterpret_cast<size_t*>(memory);
+            }
+            std::free(memory);
+        }
         
-        /** Gets the elapsed time in seconds to run all the tests (set after all tests have been run). */
-        int elapsedSeconds() const { return mElapsedSeconds; }
+    private:
+        enum { HeaderSize = alignof(std::max_align_t) };     // keeps the memory given suitably aligned
         
-    protected:
-        int mTestCount;             ///< The number of test executed.
-        int mFailureCount;          ///< The number of failures.
-        int mElapsedSeconds;        ///< The total elapsed time in seconds.
-        std::time_t mStartTime;     ///< The start time of the tests.
+        // gets whether allocations are counted
+        static std::atomic<bool>& tracked() { static std::atomic<bool> tracked(false); return tracked; }
     };
     
+#pragma mark -
+#pragma mark Hardware counters
+    
     /** 
-     OStreamResult processes test results to an output stream. 
-     @see ntk::TestResult
+     A TestCounterStats object records the hardware events counted while running a test case, or while measuring the samples of a benchmark. Events 
+     are counted per operation, i.e. for the whole test case or per iteration of the benchmark, and are negative if they could not be counted.
      */
-    class OStreamTestResult : public TestResult
-    {
-    public:
+    struct TestCounterStats {
         
-        /** 
-         Creates a new OStreamResult from the specified output stream.
-         If no output stream if specified, std::cout is used.
-         */
-        OStreamTestResult(std::ostream& os = std::cout)
-        : mOutStream(os), mIndent(0)
+        /** Creates statistics with unknown events. */
+        TestCounterStats()
+        : operations(0), cycles(-1), instructions(-1), cacheReferences(-1), cacheMisses(-1), branches(-1), branchMisses(-1), mPath("")
         {}
         
-        /** This method is called before running all tests. */
-        virtual void allTestsBegin() {
-            TestResult::allTestsBegin();
-            std::cout << std::endl << std::endl << "Running unit tests..." << std::endl << std::endl;
-        }
+        /** Gets the path of the test (set by TestResult). */
+        std::string path() const { return mPath; }
         
-        /** This method is called after all tests have been run. */
-        virtual void allTestsEnd() {
-            TestResult::allTestsEnd();
+        /** Gets the number of instructions executed per cycle, or a negative value if unknown. */
+        double ipc() const { return ratio(instructions, cycles); }
+        
+        /** Gets the fraction of the cache references that missed the cache, or a negative value if unknown. */
+        double cacheMissRate() const { return ratio(cacheMisses, cacheReferences); }
+        
+        /** Gets the fraction of the branches that were mispredicted, or a negative value if unknown. */
+        double branchMissRate() const { return ratio(branchMisses, branches); }
+        
+        long long operations;   ///< The number of operations measured, 1 for a test case or the number of measured iterations for a benchmark.
+        double cycles;          ///< The number of CPU cycles per operation.
+        double instructions;    ///< The number of instructions executed per operation.
+        double cacheReferences; ///< The number of last level cache references per operation.
+        double cacheMisses;     ///< The number of last level cache misses per operation.
+        double branches;        ///< The number of branch instructions executed per operation.
+        double branchMisses;    ///< The number of mispredicted branches per operation.
+        
+    private:
+        // gets the ratio of two event counts, negative if unknown
+        static double ratio(double count, double total) { return ((count < 0) || (total <= 0)) ? -1.0 : (count / total); }
+        
+        const char* mPath;          // the path of the test, interned for the whole run (see ntk::TestStrings)
+        friend class TestResult;    // sets the path
+    };
+    
+    /** Writes the known events of the specified statistics to the specified stream, in a human readable form. */
+    inline std::ostream& operator<<(std::ostream& os, const TestCounterStats& stats) {
+        std::ostringstream ss;
+        const char* unit = (stats.operations > 1) ? "/op" : "";
+        ss << std::fixed << std::setprecision((stats.operations > 1) ? 1 : 0);
+        if (stats.cycles >= 0)
+            ss << stats.cycles << " cycles" << unit;
+        if (stats.instructions >= 0)
+            ss << ((stats.cycles >= 0) ? ", " : "") << stats.instructions << " instructions" << unit;
+        ss << std::setprecision(2);
+        if (stats.ipc() >= 0)
+            ss << " (" << stats.ipc() << " IPC)";
+        ss << std::setprecision(1);
+        if (stats.cacheMissRate() >= 0)
+            ss << ((ss.tellp() > 0) ? ", " : "") << (100 * stats.cacheMissRate()) << "% cache misses";
+        if (stats.branchMissRate() >= 0)
+            ss << ((ss.tellp() > 0) ? ", " : "") << (100 * stats.branchMissRate()) << "% branch misses";
+        return os << ss.str();
+    }
+    
+    /**
+     TestCounters reads the hardware performance counters of the calling thread with the Linux perf_event interface, counting the cycles, instructions,
+     cache references and misses, and branches and mispredictions. Counting is enabled by the counters option (see ntk::TestOptions), the events of 
+     each test case and of the measured samples of each benchmark are then reported with TestResult::counterResult().
+     
+     The counters of a thread are opened the first time they are read. Only user space events are counted, so no privileges are needed with the 
+     default system settings. The events that can't be counted (on other systems, or when the hardware counters are not available such as in many 
+     virtual machines) are reported as unknown, and if no event can be counted the tests are only timed.
+     */
+    class TestCounters {
+    public:
+        
+        /** The counted events. */
+        enum Event {
+            Cycles,             ///< The CPU cycles.
+            Instructions,       ///< The instructions executed.
+            CacheReferences,    ///< The last level cache references.
+            CacheMisses,        ///< The last level cache misses.
+            Branches,           ///< The branch instructions executed.
+            BranchMisses,       ///< The mispredicted branches.
+            EventCount          ///< The number of counted events.
+        };
+        
+        /** The counts of the events, negative for the events that are not counted. */
+        struct Counts {
             
-            std::cout << std::endl << "Summary:" << std::endl;
-            std::cout << "  - Executed tests : " << std::setw(8) << std::right << mTestCount << std::endl;
-            std::cout << "  - Passed tests   : " << std::setw(8) << std::right << (mTestCount - mFailureCount) << std::endl;
+            /** Creates counts with the specified value for all events. */
+            explicit Counts(double value = -1.0) { std::fill(values, values + EventCount, value); }
             
-            if (failures() != 0)
-                std::cout << "  - Failed tests   : "  << std::setw(8) << std::right << mFailureCount << std::endl;
+            /** Returns true if at least one event is counted. */
+            bool isCounted() const { return *std::max_element(values, values + EventCount) >= 0; }
             
-            std::cout << std::endl << "Tests running time: " << elapsedSeconds() << "s." << std::endl << std::endl;
-        }
+            double values[EventCount];  ///< The count of each event.
+        };
         
-        /** This method is called when a test has failed. */
-        virtual void addFailure(const TestFailure& failure) {
-            TestResult::addFailure(failure);
-            std::cout << std::setw(mIndent) << "! " << failure << std::endl;
+        /** Returns true if the counters are read, i.e. counting has been enabled. */
+        static bool isEnabled() { return enabled().load(std::memory_order_relaxed); }
+        
+        /** Enables or disables counting, done by Test::runAll() for the duration of the run. */
+        static void setEnabled(bool isEnabled) { enabled().store(isEnabled, std::memory_order_relaxed); }
+        
+        /** Reads the counters of the calling thread, all the events being reported as not counted if counting is disabled. */
+        static Counts read() {
+            Counts counts;
+#ifdef __T_USE_PERF_COUNTERS
+            if (!isEnabled())
+                return counts;
+            Descriptors& current = descriptors();
+            current.open();
+            for (int i = 0; i < EventCount; ++i) {
+                uint64_t data[3];   // the count, the time the counter was enabled and the time it was actually counting
+                if ((current.fds[i] >= 0) && (::read(current.fds[i], data, sizeof(data)) == (ssize_t)sizeof(data)) && (data[2] > 0))
+                    counts.values[i] = (double)data[0] * ((double)data[1] / data[2]);   // scaled if the counter was shared with other events
+            }
+#endif
+            return counts;
         }
         
-        /** This method is called each time a test begins. */
-        virtual void testBegins(Test* test) {
-            TestResult::testBegins(test);
-            std::cout << std::setw(mIndent + 2) << ((test->type() == TestType::TestSuite) ? "+ " : "- ") << test->name() << std::endl;
-            mIndent += 2;
+        /** Gets the events counted by the calling thread since the specified counts were read. */
+        static Counts since(const Counts& start) {
+            Counts counts = read();
+            for (int i = 0; i < EventCount; ++i)
+                counts.values[i] = ((start.values[i] < 0) || (counts.values[i] < 0)) ? -1.0 : (counts.values[i] - start.values[i]);
+            return counts;
         }
         
-        /** This method is called each time a test ends. */
-        virtual void testEnds(Test* test) {
-            TestResult::testEnds(test);
-            mIndent -= 2;
+        /** Adds the specified counts to the specified total, the events not counted in either being not counted in the total. */
+        static void add(Counts& total, const Counts& counts) {
+            for (int i = 0; i < EventCount; ++i)
+                total.values[i] = ((total.values[i] < 0) || (counts.values[i] < 0)) ? -1.0 : (total.values[i] + counts.values[i]);
         }
         
-    protected:
-        std::ostream& mOutStream;   ///< The output stream.
-        unsigned int mIndent;       ///< The current indentation.
+        /** Gets the statistics of the specified counts, made while running the specified number of operations. */
+        static TestCounterStats statsOf(const Counts& counts, long long operations = 1) {
+            TestCounterStats stats;
+            double* values[EventCount] = { &stats.cycles, &stats.instructions, &stats.cacheReferences, &stats.cacheMisses, &stats.branches, 
+                                           &stats.branchMisses };
+            stats.operations = std::max(1ll, operations);
+            for (int i = 0; i < EventCount; ++i)
+                *values[i] = (counts.values[i] < 0) ? -1.0 : (counts.values[i] / stats.operations);
+            return stats;
+        }
         
     private:
-        // private copy constructor and assign operator as a stream result can't be copied
-        OStreamTestResult(const OStreamTestResult&);
-        const OStreamTestResult& operator=(const OStreamTestResult&);
+        // gets whether counting is enabled
+        static std::atomic<bool>& enabled() { static std::atomic<bool> enabled(false); return enabled; }
+        
+#ifdef __T_USE_PERF_COUNTERS
+        // the counters opened by a thread, closed when the thread exits
+        struct Descriptors {
+            Descriptors() : pid(-1) { std::fill(fds, fds + EventCount, -1); }
+            ~Descriptors() { close(); }
+            
+            // opens the counters, once per process as the counters inherited by a child process count the events of its parent
+            void open() {
+                if (pid == ::getpid())
+                    return;
+                close();
+                pid = ::getpid();
+                static const uint64_t events[EventCount] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+                                                             PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES };
+                for (int i = 0; i < EventCount; ++i) {
+                    perf_event_attr attributes;
+                    std::memset(&attributes, 0, sizeof(attributes));
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.size = sizeof(attributes);
+                    attributes.config = events[i];
+                    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    attributes.exclude_kernel = 1;
+                    attributes.exclude_hv = 1;
+                    fds[i] = (int)::syscall(__NR_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);   // the calling thread, on any CPU
+                }
+            }
+            
+            // closes the opened counters
+            void close() {
+                for (int i = 0; i < EventCount; ++i) {
+                    if (fds[i] >= 0)
+                        ::close(fds[i]);
+                    fds[i] = -1;
+                }
+            }
+            
+            int fds[EventCount];    // the file descriptor of each counter, negative if it could not be opened
+            pid_t pid;              // the process the counters were opened in
+        };
+        
+        // gets the counters of the calling thread
+        static Descriptors& descriptors() {
+#ifndef DO_NOT_USE_THREADS
+            static thread_local Descriptors descriptors;
+#else
+            static Descriptors descriptors;
+#endif
+            return descriptors;
+        }
+#endif
     };
     
 #pragma mark -
-#pragma mark Test inline implementation
+#pragma mark Assertion profile
     
-    // runs the test, using the specified Test::Result object to process the test results.
-    inline int Test::run(TestResult& result) {
-        int failuresBeforeTest = result.failures();
+    /**
+     A TestCheckStats object records how many times an assertion site, i.e. an assertion macro at a given line of a file, was checked while running a
+     test case, and the time spent in these checks. 
+     */
+    struct TestCheckStats {
         
-        result.testBegins(this);
-#ifndef DO_NOT_USE_EXCEPTIONS
-        try {
-            runTest(result);
-        } catch (std::exception& e) {
-            result.addFailure(TestFailure("Unhandled exception: " + std::string(e.what()), mName, "unknown file", -1));
-        } catch (...) {
-            result.addFailure(TestFailure("Unhandled exception: unknown", mName, "unknown file", -1));
-        }
-#else
-        runTest(result);
-#endif
-        result.testEnds(this);
+        /** Creates empty statistics for the specified assertion site. */
+        TestCheckStats(const std::string& theFile = "", int theLine = 0)
+        : file(theFile), line(theLine), count(0), duration(0), mPath("")
+        {}
         
-        return (result.failures() - failuresBeforeTest);    // return the number of failures that occured during the test
-    }
-
-    // runs all the tests, using the specified TestResult object to process the test results.
-    inline int Test::runAll(TestResult& result) {
-        result.allTestsBegin();
-        for (std::vector<Test*>::iterator it = mTests().begin(); it != mTests().end(); ++it)
-            (*it)->run(result);
-        result.allTestsEnd();
-        return result.failures();
-    }
-    
-#pragma mark -
-#pragma mark Assertion templates
+        /** Gets the path of the test (set by TestResult). */
+        std::string path() const { return mPath; }
+        
+        std::string file;   ///< The file of the assertion site.
+        int line;           ///< The line of the assertion site.
+        long long count;    ///< The number of checks made by the assertion.
+        long long duration; ///< The time spent in the checks in nanoseconds, including the evaluation of the operands and the report of the failures.
+        
+    private:
+        const char* mPath;          // the path of the test, interned for the whole run (see ntk::TestStrings)
+        friend class TestResult;    // sets the path
+    };
     
-    /** Defines a set of assertion methods to do the test checks. */
-    namespace TestCheck {
+    /**
+     TestCheckProfile measures the checks made by the assertion macros, when profiling is enabled by the profileChecks option (see ntk::TestOptions). 
+     The checks of each test case are counted and timed per assertion site by the thread running the test, then reported with 
+     TestResult::checkResult(). When profiling is disabled, a check only tests a flag.
+     */
+    class TestCheckProfile {
+    public:
         
-        /** Expresses a failure of a test and gives details about it. */
-        inline void fail(const std::string& expression, const std::string& message,
-                  TestResult& result, const std::string& testName, const std::string& file, int line) 
-        {
-            std::string condition = expression;
-            if (!message.empty()) {
-                condition += ", Note: ";
-                condition += message;
+        /** An assertion site checked by a test, with its measures. */
+        struct Site {
+            const char* file;   ///< The file of the assertion, given by __FILE__.
+            int line;           ///< The line of the assertion.
+            long long count;    ///< The number of checks.
+            long long duration; ///< The time spent in the checks in nanoseconds.
+        };
+        
+        /** The assertion sites checked by a test, in the order of their first check. */
+        typedef std::vector<Site> Sites;
+        
+        /** Measures a check from its creation to its destruction, if profiling is enabled. */
+        class Scope {
+        public:
+            /** Starts measuring a check of the assertion at the specified location. */
+            Scope(const char* file, int line) : mFile(file), mLine(line), mStartTime(isEnabled() ? TestClock::now() : -1) {}
+            
+            /** Adds the check to the sites of the test being run by the calling thread. */
+            ~Scope() {
+                if (mStartTime >= 0)
+                    add(mFile, mLine, TestClock::now() - mStartTime);
             }
-            result.addFailure(TestFailure(condition, testName, file, line));
-        }
+            
+        private:
+            const char* mFile;      // the file of the assertion
+            int mLine;              // the line of the assertion
+            long long mStartTime;   // the time the check began, negative if it is not measured
+        };
         
-        /** Returns true if x and y are equal. */
-        template <typename X, typename Y>
-        bool equal(X x, Y y) {
-            return (x == y);
-        }
-                
-        /** Returns true if x and y of floating point type are equal. */
-        template <typename X, typename Y>
-        bool differ(X x, Y y) {
-            return !(x == y);
-        }
+        /** Returns true if the checks are measured, i.e. profiling has been enabled. */
+        static bool isEnabled() { return enabled().load(std::memory_order_relaxed); }
         
-        /** Returns true if x and y are close by a maximum delta of d. */
-        template <typename X, typename Y, typename D>
-        bool close(X x, Y y, D d) {
-            return (((y - x) < d) && ((y - x) > -d));
-        }
+        /** Enables or disables profiling, done by Test::runAll() for the duration of the run. */
+        static void setEnabled(bool isEnabled) { enabled().store(isEnabled, std::memory_order_relaxed); }
         
-        /** Returns true if x is less than y. */
-        template <typename X, typename Y>
-        bool less(X x, Y y) {
-            return (x < y);
+        /** 
+         Sets the sites the checks made by the calling thread are added to, NULL to ignore the checks. Returns the previous sites, to restore once 
+         the test is over.
+         */
+        static Sites* record(Sites* sites) {
+            Sites* previous = current();
+            current() = sites;
+            return previous;
         }
         
-        /** Returns true if x is less or equal than y. */
-        template <typename X, typename Y>
-        bool lessOrEqual(X x, Y y) {
-            return (x <= y);
+        /** Adds a check of the specified duration to the sites of the calling thread. */
+        static void add(const char* file, int line, long long duration) {
+            Sites* sites = current();
+            if (sites == NULL)
+                return;
+            // the last sites are the most likely to be checked again, e.g. in a loop
+            for (Sites::reverse_iterator it = sites->rbegin(); it != sites->rend(); ++it) {
+                if ((it->line == line) && ((it->file == file) || (std::strcmp(it->file, file) == 0))) {
+                    ++it->count;
+                    it->duration += duration;
+                    return;
+                }
+            }
+            TestAllocations::Pause pause;   // profiling is not part of the test
+            Site site = { file, line, 1, duration };
+            sites->push_back(site);
         }
         
-        /** Returns true if x is more than y. */
-        template <typename X, typename Y>
-        bool more(X x, Y y) {
-            return (x > y);
+        /** Gets the statistics of the specified site. */
+        static TestCheckStats statsOf(const Site& site) {
+            TestCheckStats stats(site.file, site.line);
+            stats.count = site.count;
+            stats.duration = site.duration;
+            return stats;
         }
         
-        /** Returns true if x is more or equal than y. */
-        template <typename X, typename Y>
-        bool moreOrEqual(X x, Y y) {
-            return (x >= y);
+    private:
+        // gets whether profiling is enabled
+        static std::atomic<bool>& enabled() { static std::atomic<bool> enabled(false); return enabled; }
+        
+        // gets the sites of the test run by the calling thread
+        static Sites*& current() {
+#ifndef DO_NOT_USE_THREADS
+            static thread_local Sites* sites = NULL;
+#else
+            static Sites* sites = NULL;
+#endif
+            return sites;
         }
+    };
+    
+#pragma mark -
+#pragma mark Signal handling
+    
+#ifdef __T_USE_SIGNAL_RECOVERY
+    
+    /**
+     TestSignals recovers from the crashes of the tests, i.e. the signals raised by invalid memory accesses (including stack overflows), arithmetic 
+     errors, illegal instructions and aborts. The handlers are installed once by Test::runAll() with sigaction() and run on an alternate stack of the
+     crashing thread. Each thread running a test sets a recovery point with sigsetjmp() (see Recovery), the handler jumps back to it and the test is
+     reported as failed, so crashes are recovered in parallel worker threads as well. A signal raised by a thread not running a test terminates the 
+     process as usual.
+     
+     Recovering does not run the destructors of the objects of the crashed test, so its resources are leaked. Tests may be isolated in child 
+     processes when a crash must not affect the other tests (see ntk::TestOptions).
+     */
+    class TestSignals {
+    public:
         
-        /** Returns true if the data of the specified size at position x and y is the same.*/
-        inline bool sameData(const void* x, const void* y, unsigned int size) {
-            if (size == 0)
-                return true;
+        /** The recovery point of a thread running a test, the innermost one being jumped to when the thread crashes. */
+        struct Recovery {
             
-            if (x == y)
-                return true;
+            /** Makes the recovery point the current one of the calling thread, sigsetjmp() must then be called with its point. */
+            Recovery() : previous(current()) {
+                alternateStack();
+                current() = this;
+            }
             
-            if ((x == NULL) || (y == NULL))
-                return false;
+            /** Restores the previous recovery point of the calling thread. */
+            ~Recovery() { current() = previous; }
             
-            const char* cx = (const char *)x;
-            const char* cy = (const char *)y;
-            while (size--)
-                if (*cx++ != *cy++)
-                    return false;
+            sigjmp_buf point;   ///< The point jumped to with the number of the signal, set by the test runner with sigsetjmp().
+            Recovery* previous; ///< The recovery point of the outer test, NULL if none.
             
-            return true;
+        private:
+            // private copy constructor and assign operator as a recovery point can't be copied
+            Recovery(const Recovery&);
+            const Recovery& operator=(const Recovery&);
+        };
+        
+        /** Installs the signal handlers, only once. */
+        static void install() {
+            static bool installed = false;
+            if (installed)
+                return;
+            installed = true;
+            
+            struct sigaction action;
+            std::memset(&action, 0, sizeof(action));
+            action.sa_handler = &handle;
+            action.sa_flags = SA_ONSTACK | SA_NODEFER;  // the signal is not blocked after the jump, so sigsetjmp() does not save the signal mask
+            sigemptyset(&action.sa_mask);
+            const int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT
+#ifdef SIGSYS
+                                    , SIGSYS
+#endif
+                                  };
+            for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); ++i)
+                ::sigaction(signals[i], &action, NULL);
         }
         
-        /** Returns a string corresponding to the specified value. */
-        template <typename T>
-        std::string stringValue(const T& value) {
+        /** Gets the failure condition of a test that crashed with the specified signal. */
+        static std::string conditionOf(int signalNumber) {
             std::ostringstream ss;
-            ss << value;
+            ss << "Test crashed with signal " << signalNumber << " (" << ::strsignal(signalNumber) << ")";
             return ss.str();
         }
         
-    }
+    private:
+        // jumps back to the recovery point of the crashing thread, or terminates the process if the thread is not running a test
+        static void handle(int signalNumber) {
+            Recovery* recovery = current();
+            if (recovery != NULL) {
+                sigset_t signals;   // if the signal is blocked while handled (by a sanitizer for example), siglongjmp() would keep it blocked
+                sigemptyset(&signals);
+                sigaddset(&signals, signalNumber);
+                pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+                siglongjmp(recovery->point, signalNumber);
+            }
+            ::signal(signalNumber, SIG_DFL);
+            ::raise(signalNumber);
+        }
+        
+        // the alternate stack of a thread, used by the handlers as the stack of the thread may have overflowed
+        struct AlternateStack {
+            AlternateStack() : enabled(false) {
+                stack_t stack;
+                if ((::sigaltstack(NULL, &stack) != 0) || !(stack.ss_flags & SS_DISABLE))
+                    return;     // keeps the alternate stack set by someone else, such as a sanitizer
+                TestAllocations::Pause pause;   // not part of the first test run by the thread
+                memory.resize(std::max<size_t>(SIGSTKSZ, 64 * 1024));
+                stack.ss_sp = &memory[0];
+                stack.ss_size = memory.size();
+                stack.ss_flags = 0;
+                enabled = (::sigaltstack(&stack, NULL) == 0);
+            }
+            ~AlternateStack() {
+                if (!enabled)
+                    return;
+                stack_t stack;
+                std::memset(&stack, 0, sizeof(stack));
+                stack.ss_flags = SS_DISABLE;
+                ::sigaltstack(&stack, NULL);
+            }
+            std::vector<char> memory;   // the stack memory
+            bool enabled;               // true if the stack is used by the thread
+        };
+        
+        // sets the alternate stack of the calling thread, once per thread
+        static void alternateStack() {
+#ifndef DO_NOT_USE_THREADS
+            static thread_local AlternateStack stack;
+#else
+            static AlternateStack stack;
+#endif
+        }
+        
+        // gets the current recovery point of the calling thread
+        static Recovery*& current() {
+#ifndef DO_NOT_USE_THREADS
+            static thread_local Recovery* recovery = NULL;
+#else
+            static Recovery* recovery = NULL;
+#endif
+            return recovery;
+        }
+    };
     
-#pragma mark -
-#pragma mark Signal -> exception handling
+#elif !defined (DO_NOT_USE_EXCEPTIONS) && !defined (DO_NOT_CATCH_SIGNALS)
     
-#if !defined (DO_NOT_USE_EXCEPTIONS) && !defined (DO_NOT_CATCH_SIGNALS)
+    // without sigaction() and sigsetjmp(), the signals are translated to exceptions thrown by the signal handlers
     
     /** Creates a new signal exception class. */
 #   define SIGNAL_EXCEPTION(signalNumber, name) \
@@ -539,9 +1221,6 @@ namespace ntk {
 #   define SIGNAL_EXCEPTION_SETUP(name) \
     static TestSignalTranslator<name##Exception> __##name##ExceptionTranslator; 
 
-    /** Setup the global signal to exception handler (called automatically by the TEST macro to avoid forgetting it). */
-#   define SETUP_EXCEPTIONS()  ntk::TestSignalExceptionHandler::setup()
-    
     /** Signal to exception translator template helper. */
     template <class SignalExceptionClass> 
     class TestSignalTranslator
@@ -582,7 +1261,7 @@ namespace ntk {
     SIGNAL_EXCEPTION(SIGKILL, Kill);            
 #endif
     
-    /** Helper class to setup the signal to exception handler. */
+    /** Helper class to setup the signal to exception handler (done once by Test::runAll()). */
     struct TestSignalExceptionHandler {
         inline static void setup() {
             SIGNAL_EXCEPTION_SETUP(Termination);
@@ -602,40 +1281,5262 @@ namespace ntk {
 #endif
         }
     };
-        
+    
+    /** TestSignals translates the signals to exceptions, the handlers being installed once by Test::runAll(). */
+    struct TestSignals {
+        static void install() { TestSignalExceptionHandler::setup(); } ///< Installs the signal handlers.
+    };
+    
 #else
-
+    
+    /** TestSignals does nothing when the signals are not caught. */
+    struct TestSignals {
+        static void install() {}    ///< Does nothing.
+    };
+    
+#endif // __T_USE_SIGNAL_RECOVERY
+    
+    /** Kept for compatibility, the signal handlers are installed once by Test::runAll(). */
 #   define SETUP_EXCEPTIONS()
     
-#endif // !defined (DO_NOT_USE_EXCEPTIONS) && !defined (DO_NOT_CATCH_SIGNALS)
+#pragma mark -
+#pragma mark Test definition
+    
+    class TestResult;
+    class TestFailure;
+    class TestSuite;
+    class TestFixture;
+    struct TestBenchmarkStats;
+    
+    /**
+     Test is a base class for all tests. It provides method for running individual tests (runTest) as well as data members for recording the name and type of
+     the test. The type of test may be used in a ntk::TestResult class for processing differently differents test types (for example test case, test 
+     suites, etc).
+     
+     A test class is automatically registred in a global test set so you can use the static method Test::run() to run all tests at once.
+     Tests may be constructed and organized using the TEST, FIXTURE, SUITE and SUBSUITE macros, provided for convenience.
+     
+     @see ntk::TestSuite
+     @see ntk::TestFixture
+     @see ntk::TestResult
+     @see ntk::TestType
+     */
+    class Test {
+    public:
+        
+        /** A name with a static lifetime, such as the names given by the macros, that the tests keep without copying it. */
+        struct StaticName {
+            
+            /** Wraps the specified name, which must have a static lifetime. */
+            explicit StaticName(const char* theName) : name(theName) {}
+            
+            const char* name;   ///< The wrapped name.
+        };
+        
+        /** 
+         Creates a new test with the specified name and type, keeping a copy of the name.
+         The test may be specified to automatically register itself in the global test set (disabled by default).
+         */
+        Test(const char* name, TestType type = TestType::TestCase, bool autoRegisterTest = false) 
+        : mName(NULL), mNameCopy(copyName(name, std::strlen(name))), mDuration(0), mParent(NULL), mType(type), mSoftFailures(0)
+        { mName = mNameCopy.get(); if (autoRegisterTest) registerTest(this); }
+        
+        /** Creates a new test with the specified name and type, keeping a copy of the name. */
+        Test(const std::string& name, TestType type = TestType::TestCase, bool autoRegisterTest = false) 
+        : mName(NULL), mNameCopy(copyName(name.c_str(), name.size())), mDuration(0), mParent(NULL), mType(type), mSoftFailures(0)
+        { mName = mNameCopy.get(); if (autoRegisterTest) registerTest(this); }
+        
+        /** Creates a new test with the specified name and type, the name having a static lifetime it is not copied. */
+        Test(StaticName name, TestType type = TestType::TestCase, bool autoRegisterTest = false) 
+        : mName(name.name), mDuration(0), mParent(NULL), mType(type), mSoftFailures(0)
+        { if (autoRegisterTest) registerTest(this); }
+        
+        /** Destroys the test. */
+        virtual ~Test() {}
+        
+        /**
+         Runs the test, using the specified Test::Result object to process the test results.
+         Do not override this method to implement the test code, the method runTest() should be used instead.
+         This method should be overriden with great care as it all the necessary calls to enable fixture support, exception handling and result commits.
+         */
+        virtual int run(TestResult& result); // implemented later because of TestFailure and TestResult dependencies
+        
+        /** Gets the type of the test. */
+        TestType type() const { return mType; }
+        
+        /** Gets the name of the test. */
+        const char* name() const { return mName; }
+        
+        /** Gets the suite the test is part of, or NULL if it is not part of a suite. */
+        TestSuite* parent() const { return mParent; }
+        
+        /** Gets the scratch memory of the test, released at the end of each run of the test. */
+        TestArena& arena() { return mArena; }
+        
+        /** Returns true if the test is a group of tests (see ntk::TestSuite). */
+        virtual bool isSuite() const { return false; }
+        
+        /** Returns true if the test must be run serially, i.e. never concurrently with any other test. */
+        virtual bool isSerial() const { return false; }
+        
+        /** Gets the maximum time in milliseconds the test may run, or 0 to use the default timeout of the run (see ntk::TestOptions). */
+        virtual unsigned int timeout() const { return 0; }
+        
+        /** Gets the global test set, i.e. the tests run by runAll(), creating the tests declared with the macros if needed. */
+        static const std::vector<Test*>& registeredTests() { loadRegisteredTests(); return mTests(); }
+        
+        /** Gets the path of the specified test in the global test set, i.e. the names of its parent suites and its own name separated by "/". */
+        static std::string pathOf(const Test* test); // implemented later because of TestSuite dependency
+        
+        /** Gets the time in nanoseconds spent running the test the last time it was run, including its sub tests if any. */
+        long long duration() const { return mDuration; }
+        
+        /** Gets the time in nanoseconds spent running the test the last time it was run, excluding the time spent in its sub tests if any. */
+        virtual long long exclusiveDuration() const { return mDuration; }
+        
+        /**
+         Runs all the tests, using the specified TestResult object to process the test results.
+         The tests are dispatched on the number of worker threads (or child processes if tests are isolated) specified in the options, or serially if 
+         jobs is 1 (the default). If jobs is 0, one worker per available hardware thread is used. A number of jobs may be given directly instead of options.
+         In parallel mode the results are still processed in declaration order and from the calling thread only, so TestResult classes do not need to be 
+         thread-safe.
+         */
+        static int runAll(TestResult& result, const TestOptions& options = TestOptions()); // implemented later because of TestResult dependency
+        
+        /**
+         Runs all the tests with the specified options, reporting the results with the report selected in the options (as text by default) to the 
+         output file of the options or the standard output. Returns the number of failures, or EXIT_FAILURE if the output file can't be written.
+         As an exit status only keeps 8 bits, the result must not be returned from main() as is (RUN_TESTS returns EXIT_FAILURE if it isn't 0).
+         */
+        static int runAll(const TestOptions& options); // implemented later because of TestResult dependencies
+        
+        /** 
+         Prints the path of all the test cases selected by the specified options to the specified stream, one per line. Returns 0.
+         The declared tests are listed from their descriptors if they have not been created yet, only the parameterized tests are created.
+         */
+        static int listAll(std::ostream& os, const TestOptions& options = TestOptions()); // implemented later because of TestFilter dependency
+        
+    protected:
+        
+        /** The method containing the actual test code, to be overriden. */
+        virtual void runTest(TestResult& result) = 0;
+        
+        /** Runs the specified child test, or commits its results if it has already been run by a worker thread. */
+        static void dispatch(Test* test, TestResult& result); // implemented later because of TestWorkerPool dependency
+        
+        /** 
+         Counts a failed soft check of the test (see TEM_CHECK) and returns true if it must be reported. Once the limit of failed soft checks of
+         the run is exceeded, the failure of the check at the specified location is reported as such and false is returned: the test must stop.
+         */
+        bool countSoftFailure(TestResult& result, const char* file, int line); // implemented later because of TestResult dependency
+        
+    private:
+        static std::vector<Test*>& mTests() { static std::vector<Test*> tests; return tests; } // the list of all tests
+        static void registerTest(Test* test) { mTests().push_back(test); } // registers a new test in the global list (automatically done)
+        static void loadRegisteredTests(); // creates the tests of the registry and adds them to the global list, only once
+        static bool& mLoaded() { static bool loaded = false; return loaded; } // true once the tests of the registry have been created
+        static bool findPath(const std::vector<Test*>& tests, const Test* test, std::string& path); // finds the path of a test in a test set
+        static void execute(TestResult& result, const TestOptions& options); // runs all the tests with the specified options
+        static void runOrReplay(Test* test, TestResult& result); // runs a test, or commits its results if it has already been run
+        static unsigned int& mMaxSoftFailures() { static unsigned int limit = 100; return limit; } // the limit of failed soft checks per test
+        static char* copyName(const char* name, size_t length) { // copies a name of the specified length
+            char* copy = new char[length + 1];
+            std::memcpy(copy, name, length);
+            copy[length] = '\0';
+            return copy;
+        }
+
+        const char* mName;                  // the name of the test
+        std::unique_ptr<char[]> mNameCopy;  // the copy of the name if it has no static lifetime
+        long long mDuration;                // the duration of the last run in nanoseconds
+        TestSuite* mParent;                 // the suite the test is part of
+        TestArena mArena;                   // the scratch memory of the test
+        TestType mType;                     // the type of the test
+        unsigned int mSoftFailures;         // the number of failed soft checks during the current run
+        
+        friend class TestSuite;             // sets the parent of its tests
+        friend class TestProcessPool;       // sets the duration of tests run in child processes
+        friend class TestWatchdog;          // sets the duration of tests that timed out
+        friend class TestBatch;             // sets its duration and the parent of its cases
+        
+        Test(const Test&);                  // not copyable, the name may be kept by the test
+        const Test& operator=(const Test&);
+    };
+    
+#pragma mark -
+#pragma mark Shared fixtures
+    
+    /**
+     TestSharedFixtures holds fixtures shared by several tests, each one being created the first time a test uses it.
+     The fixtures of a suite are shared by its tests and released at the end of the suite (see SUITE_FIXTURE), global fixtures are shared by all the
+     tests and released at the end of the run (see GLOBAL_FIXTURE). Fixtures are only created if a test that uses them is run.
+     Tests run in parallel may use the same fixtures concurrently, so a shared fixture is only accessible for reading.
+     @see ntk::TestFixture
+     */
+    class TestSharedFixtures {
+    public:
+        
+        /** Creates an empty set of fixtures. */
+        TestSharedFixtures() {}
+        
+        /** 
+         Gets the fixture of the specified class, creating it if needed. 
+         A released fixture is only destroyed when the last test using it completes, i.e. when the last pointer to it is destroyed.
+         */
+        template <class T>
+        std::shared_ptr<const T> get() {
+#ifndef DO_NOT_USE_THREADS
+            std::lock_guard<std::mutex> lock(mMutex);   // held during the setup, so a fixture is only created once
+#endif
+            for (std::vector<Fixture>::const_iterator it = mFixtures.begin(); it != mFixtures.end(); ++it)
+                if (it->first == key<T>())
+                    return std::static_pointer_cast<const T>(it->second);
+            std::shared_ptr<const T> fixture(new T());
+            mFixtures.push_back(Fixture(key<T>(), fixture));
+            return fixture;
+        }
+        
+        /** Releases all the fixtures, they are created again if they are used after. */
+        void release() {
+            std::vector<Fixture> released;
+            {
+#ifndef DO_NOT_USE_THREADS
+                std::lock_guard<std::mutex> lock(mMutex);
+#endif
+                released.swap(mFixtures);
+            }
+            // teardowns run here if no test is using the fixtures anymore
+        }
+        
+        /** Gets the fixtures shared by all the tests of a run. */
+        static TestSharedFixtures& global() { static TestSharedFixtures fixtures; return fixtures; }
+        
+    private:
+        typedef std::pair<const void*, std::shared_ptr<const TestFixture> > Fixture;    // a fixture with the key of its class
+        
+        // gets a unique key for each fixture class
+        template <class T>
+        static const void* key() { static const char key = 0; return &key; }
+        
+        std::vector<Fixture> mFixtures;     // the fixtures created
+#ifndef DO_NOT_USE_THREADS
+        std::mutex mMutex;                  // protects the fixtures
+#endif
+        
+        // private copy constructor and assign operator as fixtures must not be copied
+        TestSharedFixtures(const TestSharedFixtures&);
+        const TestSharedFixtures& operator=(const TestSharedFixtures&);
+    };
+    
+#pragma mark -
+#pragma mark Test suite definition
+    
+    /**
+     A TestSuite is essentially a group of tests.
+     @see ntk::Test
+     */
+    class TestSuite : public Test 
+    {
+    public:
+        
+        /** 
+         Creates a new test suite with the specified name and type, keeping a copy of the name. 
+         The test suite may be specified to automatically register itself in the global test set (enabled by default).
+         */
+        TestSuite(const char* name, TestType type = TestType::TestSuite, bool autoRegisterTestGroup = true)
+        : Test(name, type, autoRegisterTestGroup), mSerial(false)
+        {}
+        
+        /** Creates a new test suite with the specified name and type, keeping a copy of the name. */
+        TestSuite(const std::string& name, TestType type = TestType::TestSuite, bool autoRegisterTestGroup = true)
+        : Test(name, type, autoRegisterTestGroup), mSerial(false)
+        {}
+        
+        /** Creates a new test suite with the specified name and type, the name having a static lifetime it is not copied. */
+        TestSuite(StaticName name, TestType type = TestType::TestSuite, bool autoRegisterTestGroup = true)
+        : Test(name, type, autoRegisterTestGroup), mSerial(false)
+        {}
+        
+        /** Destroys the test suite. */
+        virtual ~TestSuite() {}
+        
+        /** Adds a test to the test suite. */
+        void addTest(Test* test) { mTests.push_back(test); test->mParent = this; }
+        
+        /** Gets the tests that are part of the suite. */
+        const std::vector<Test*>& tests() const { return mTests; }
+        
+        /** Reorders randomly the tests of the suite and of its sub suites, the order only depending on the state of the specified generator. */
+        void shuffle(std::mt19937& random) { shuffle(mTests, random); }
+        
+        /** Reorders randomly the specified tests and the tests of their sub suites, the order only depending on the state of the specified generator. */
+        static void shuffle(std::vector<Test*>& tests, std::mt19937& random) {
+            for (size_t i = tests.size(); i > 1; --i)
+                std::swap(tests[i - 1], tests[random() % i]);   // std::shuffle is not used as its results differ between implementations
+            for (std::vector<Test*>::iterator it = tests.begin(); it != tests.end(); ++it)
+                if ((*it)->isSuite())
+                    static_cast<TestSuite*>(*it)->shuffle(random);
+        }
+        
+        /** Moves the specified tests first among the tests of the suite and of its sub suites, the order of the other tests being kept. */
+        void moveFirst(const std::set<const Test*>& first) { moveFirst(mTests, first); }
+        
+        /** Moves the specified tests first among the specified tests and the tests of their sub suites, the order of the other tests being kept. */
+        static void moveFirst(std::vector<Test*>& tests, const std::set<const Test*>& first) {
+            std::vector<Test*> others;
+            size_t count = 0;
+            for (std::vector<Test*>::iterator it = tests.begin(); it != tests.end(); ++it) {
+                if ((*it)->isSuite())
+                    static_cast<TestSuite*>(*it)->moveFirst(first);
+                if (first.find(*it) != first.end())
+                    tests[count++] = *it;
+                else
+                    others.push_back(*it);
+            }
+            std::copy(others.begin(), others.end(), tests.begin() + count);
+        }
+        
+        /** Returns true, as a test suite is a group of tests. */
+        virtual bool isSuite() const { return true; }
+        
+        /**
+         Sets whether the tests of this suite (including its sub suites) must be run serially, i.e. never concurrently with any other test.
+         This only matters when tests are run in parallel.
+         */
+        void setSerial(bool serial) { mSerial = serial; }
+        
+        /** Returns true if the tests of this suite must be run serially. */
+        virtual bool isSerial() const { return mSerial; }
+        
+        /** Gets the time in nanoseconds spent running the suite the last time it was run, excluding the time spent in its tests. */
+        virtual long long exclusiveDuration() const {
+            long long duration = this->duration();
+            for (std::vector<Test*>::const_iterator it = mTests.begin(); it != mTests.end(); ++it)
+                duration -= (*it)->duration();
+            return std::max(0ll, duration);    // tests run in parallel may overlap
+        }
+        
+        /** Gets the fixtures shared by the tests of the suite, released at the end of each run of the suite. */
+        TestSharedFixtures& fixtures() { return mFixtures; }
+        
+        /** Gets the fixtures shared by the specified test with the other tests of its suite, or the global fixtures if it is not part of a suite. */
+        static TestSharedFixtures& fixturesOf(const Test* test) {
+            return (test->parent() != NULL) ? test->parent()->fixtures() : TestSharedFixtures::global();
+        }
+        
+        /**
+         Sets the current test suite.
+         If the test suite provided is NULL, returns the current test suite.
+         */
+        static TestSuite* currentTestSuite(TestSuite* testSuite) {
+            // warning, default test suite won't be registered if a test suite is declared!
+            static TestSuite defaultTestSuite("DefaultTestSuite", TestType::TestSuite, (testSuite == NULL));
+            static TestSuite* currentSuite = &defaultTestSuite;
+            if (testSuite != NULL)
+                currentSuite = testSuite;
+            return currentSuite;
+        }
+        
+    protected:
+        
+        /** The method containing the actual test code, to be overriden. */
+        virtual void runTest(TestResult& result) {
+            for (std::vector<Test*>::iterator it = mTests.begin(); it != mTests.end(); ++it)
+                dispatch(*it, result);
+            mFixtures.release();
+        }
+        
+        std::vector<Test*> mTests;      // the tests that are part of the group
+        bool mSerial;                   // true if the tests must not be run in parallel
+        TestSharedFixtures mFixtures;   // the fixtures shared by the tests
+    };
+    
+#pragma mark -
+#pragma mark Test registration
+    
+    /**
+     A TestDescriptor describes a test declared with the helper macros (TEST, SUITE, SUBSUITE...) and how to create it.
+     Descriptors are constant aggregates, so they are initialized at compile time and can be discovered without running any code.
+     @see ntk::TestRegistry
+     */
+    struct TestDescriptor {
+        
+        /** The kinds of declared tests. */
+        enum Kind {
+            TestCase,   ///< A test case, part of the last suite declared before it in the same file.
+            ParameterizedTest,  ///< A parameterized test, part of the last suite declared before it in the same file, its cases are created with it.
+            Suite,      ///< A top level test suite.
+            SubSuite,   ///< A test suite that is part of another suite.
+            SuitePath   ///< A test suite identified by its path, shared by all the files declaring it.
+        };
+        
+        Kind kind;                  ///< The kind of test.
+        const char* name;           ///< The name of the test.
+        const char* file;           ///< The file in which the test is declared.
+        int line;                   ///< The line at which the test is declared.
+        int order;                  ///< The declaration order in the translation unit, for tests declared on the same line.
+        Test& (*instance)();        ///< Gets the test, creating it on the first call, NULL for a suite path.
+        Test& (*parentInstance)();  ///< Gets the parent suite of a sub suite, NULL otherwise.
+    };
+    
+#ifdef __T_USE_TEST_SECTION
+    
+    // bounds of the linker section containing the pointers to all descriptors, defined by the linker (weak if no test is declared)
+    extern "C" {
+        extern const TestDescriptor* const __start_ntk_test_registry[] __attribute__((weak, visibility("hidden")));
+        extern const TestDescriptor* const __stop_ntk_test_registry[] __attribute__((weak, visibility("hidden")));
+    }
+    
+#endif
+    
+    /**
+     TestRegistry gives access to the descriptors of all the tests declared with the helper macros, without creating the tests.
+     Descriptors are collected from a linker section when supported, or from a list of static registrars otherwise.
+     @see ntk::TestDescriptor
+     */
+    class TestRegistry {
+    public:
+        
+        /** Links a descriptor in the registry using only static storage, when linker sections are not used. */
+        class Registrar {
+        public:
+            /** Registers the specified descriptor. */
+            Registrar(const TestDescriptor& descriptor) : mDescriptor(&descriptor), mNext(first()) { first() = this; }
+            
+        private:
+            const TestDescriptor* mDescriptor;  // the registered descriptor
+            const Registrar* mNext;             // the previously registered descriptor
+            
+            // gets the last registrar, constant initialized
+            static const Registrar*& first() { static const Registrar* registrar = NULL; return registrar; }
+            
+            friend class TestRegistry;
+        };
+        
+        /** The tests standing for the declared tests, by the function creating the declared test (see ntk::TestTree). */
+        typedef std::map<Test& (*)(), Test*> Tests;
+        
+        /** Gets the descriptors of all the declared tests, sorted by file then declaration order. */
+        static std::vector<const TestDescriptor*> descriptors() {
+            std::vector<const TestDescriptor*> descriptors;
+#ifdef __T_USE_TEST_SECTION
+            for (const TestDescriptor* const* it = __start_ntk_test_registry; it != __stop_ntk_test_registry; ++it)
+                if (*it != NULL)
+                    descriptors.push_back(*it);
+#endif
+            for (const Registrar* registrar = Registrar::first(); registrar != NULL; registrar = registrar->mNext)
+                descriptors.push_back(registrar->mDescriptor);
+            std::sort(descriptors.begin(), descriptors.end(), isDeclaredBefore);
+            return descriptors;
+        }
+        
+    private:
+        // returns true if a test is declared before another one
+        static bool isDeclaredBefore(const TestDescriptor* descriptor, const TestDescriptor* other) {
+            int file = std::strcmp(descriptor->file, other->file);
+            if (file != 0)
+                return (file < 0);
+            return (descriptor->line != other->line) ? (descriptor->line < other->line) : (descriptor->order < other->order);
+        }
+    };
+    
+#pragma mark -
+#pragma mark Test selection
+    
+    /**
+     TestDurations stores the recorded durations of tests, identified by their path.
+     Durations are saved in a text file with one "duration path" line per test, the duration being expressed in nanoseconds, so files from different 
+     runs can simply be concatenated (the last duration of a test is used).
+     */
+    class TestDurations {
+    public:
+        
+        /** Creates empty durations. */
+        TestDurations() : mTotal(0) {}
+        
+        /** Loads the durations from the specified file, in addition to the current ones. Returns false if the file can't be read. */
+        bool load(const std::string& fileName) {
+            std::ifstream file(fileName.c_str());
+            if (!file)
+                return false;
+            long long duration;
+            std::string path;
+            while ((file >> duration) && std::getline(file >> std::ws, path))
+                set(path, duration);
+            return true;
+        }
+        
+        /** Saves the durations to the specified file. Returns false if the file can't be written. */
+        bool save(const std::string& fileName) const {
+            std::ofstream file(fileName.c_str());
+            for (std::map<std::string, long long>::const_iterator it = mDurations.begin(); it != mDurations.end(); ++it)
+                file << it->second << " " << it->first << "\n";
+            return (bool)file.flush();
+        }
+        
+        /** Gets the duration in nanoseconds of the test with the specified path, or -1 if unknown. */
+        long long get(const std::string& path) const {
+            std::map<std::string, long long>::const_iterator it = mDurations.find(path);
+            return (it == mDurations.end()) ? -1 : it->second;
+        }
+        
+        /** Sets the duration in nanoseconds of the test with the specified path. */
+        void set(const std::string& path, long long duration) {
+            std::pair<std::map<std::string, long long>::iterator, bool> entry = mDurations.insert(std::make_pair(path, duration));
+            if (!entry.second) {
+                mTotal -= entry.first->second;
+                entry.first->second = duration;
+            }
+            mTotal += duration;
+        }
+        
+        /** Gets the duration in nanoseconds of the test with the specified path, or the average duration if unknown. */
+        long long estimate(const std::string& path) const {
+            long long duration = get(path);
+            return (duration >= 0) ? duration : average();
+        }
+        
+        /** Gets the average duration in nanoseconds of all the tests, or 1 if no duration is known. */
+        long long average() const { return mDurations.empty() ? 1 : (mTotal / (long long)mDurations.size()); }
+        
+        /** Records the durations of the specified tests that have been run with the specified filter, as measured during their last run. */
+        void record(const std::vector<Test*>& tests, const class TestFilter& filter, const std::string& parentPath = ""); // implemented later
+        
+        /** Returns true if no duration is known. */
+        bool empty() const { return mDurations.empty(); }
+        
+    private:
+        std::map<std::string, long long> mDurations;    // the durations, by test path
+        long long mTotal;                               // the sum of the durations, so the average is not computed for each unknown test
+    };
+    
+    /**
+     TestFailures stores the paths of the tests that failed during the last runs.
+     Failures are saved in a text file with one path per line. A test is removed from the list once it passes again, tests that have not been run 
+     are kept so the list can be used across runs of different selections.
+     */
+    class TestFailures {
+    public:
+        
+        /** Loads the failed tests from the specified file, in addition to the current ones. Returns false if the file can't be read. */
+        bool load(const std::string& fileName) {
+            std::ifstream file(fileName.c_str());
+            if (!file)
+                return false;
+            std::string path;
+            while (std::getline(file, path))
+                if (!path.empty())
+                    mPaths.insert(path);
+            return true;
+        }
+        
+        /** Saves the failed tests to the specified file. Returns false if the file can't be written. */
+        bool save(const std::string& fileName) const {
+            std::ofstream file(fileName.c_str());
+            for (std::set<std::string>::const_iterator it = mPaths.begin(); it != mPaths.end(); ++it)
+                file << *it << "\n";
+            return (bool)file.flush();
+        }
+        
+        /** Returns true if the test with the specified path has failed. */
+        bool contains(const std::string& path) const { return (mPaths.find(path) != mPaths.end()); }
+        
+        /** Records the results of the specified tests that have been run with the specified filter. */
+        void record(const std::vector<Test*>& tests, const class TestFilter& filter, const std::string& parentPath = ""); // implemented later
+        
+        /** Returns true if no test has failed. */
+        bool empty() const { return mPaths.empty(); }
+        
+    private:
+        std::set<std::string> mPaths;   // the paths of the failed tests
+    };
+    
+    /**
+     TestBaseline records the reference median of each benchmark, keyed by its path, in a file meant to be kept with the sources.
+     During a run with a baseline, a benchmark fails if its median is slower than the reference by more than the allowed regression.
+     @see ntk::TestOptions::baselineFile
+     */
+    class TestBaseline {
+    public:
+        
+        /** Creates an empty baseline, allowing the specified regression of the medians in percent. */
+        TestBaseline(unsigned int maxRegression = 10) : mMaxRegression(maxRegression) {}
+        
+        /** Loads the medians from the specified file, in addition to the current ones. Returns false if the file can't be read. */
+        bool load(const std::string& fileName) {
+            std::ifstream file(fileName.c_str());
+            if (!file)
+                return false;
+            double median;
+            std::string path;
+            while ((file >> median) && std::getline(file >> std::ws, path))
+                mMedians[path] = median;
+            return true;
+        }
+        
+        /** Saves the medians to the specified file. Returns false if the file can't be written. */
+        bool save(const std::string& fileName) const {
+            std::ofstream file(fileName.c_str());
+            file << std::setprecision(6);
+            for (std::map<std::string, double>::const_iterator it = mMedians.begin(); it != mMedians.end(); ++it)
+                file << it->second << " " << it->first << "\n";
+            return (bool)file.flush();
+        }
+        
+        /** Gets the median in nanoseconds per iteration of the benchmark with the specified path, or a negative value if unknown. */
+        double get(const std::string& path) const {
+            std::map<std::string, double>::const_iterator it = mMedians.find(path);
+            return (it == mMedians.end()) ? -1.0 : it->second;
+        }
+        
+        /** Sets the median in nanoseconds per iteration of the benchmark with the specified path. */
+        void set(const std::string& path, double median) { mMedians[path] = median; }
+        
+        /** Records the medians of the specified benchmark statistics. */
+        void record(const std::vector<TestBenchmarkStats>& benchmarks);     // implemented later
+        
+        /** Reports a failure if the median of the specified benchmark statistics regressed compared to the baseline. */
+        void check(Test& test, const TestBenchmarkStats& stats, TestResult& result) const;   // implemented later
+        
+        /** Gets the baseline used by the current run, or NULL if benchmarks are not checked. */
+        static const TestBaseline*& active() { static const TestBaseline* baseline = NULL; return baseline; }
+        
+    private:
+        std::map<std::string, double> mMedians; // the medians, by benchmark path
+        unsigned int mMaxRegression;            // the regression allowed in percent
+    };
+    
+    /**
+     A TestBenchmarkDelta object estimates how the durations of a benchmark changed compared to a reference run, from the samples of both runs.
+     The ratio of the durations is the Hodges-Lehmann estimator (the median of the ratios of all the pairs of samples) with its distribution free
+     confidence interval, and the significance of the change is given by the Mann-Whitney U test, so that neither assumes normal durations.
+     */
+    struct TestBenchmarkDelta {
+        
+        /** Creates an estimate of no change. */
+        TestBenchmarkDelta() : ratio(1), lower(1), upper(1), pValue(1), samples(0), referenceSamples(0) {}
+        
+        double ratio;           ///< The estimated ratio of the durations over the reference durations, above 1 for a regression.
+        double lower;           ///< The lower bound of the confidence interval of the ratio.
+        double upper;           ///< The upper bound of the confidence interval of the ratio.
+        double pValue;          ///< The probability of a difference at least as large between samples of the same distribution (two-sided).
+        int samples;            ///< The number of samples.
+        int referenceSamples;   ///< The number of samples of the reference run.
+        
+        /** The confidence level of the interval, the change being significant if the p-value is below 1 - confidence. */
+        static double confidence() { return 0.95; }
+        
+        /** Returns true if the change is significant. */
+        bool isSignificant() const { return pValue < 1.0 - confidence(); }
+        
+        /** Estimates the change between the specified samples and the reference samples, in nanoseconds per iteration. */
+        static TestBenchmarkDelta between(const std::vector<double>& samples, const std::vector<double>& reference) {
+            TestBenchmarkDelta delta;
+            delta.samples = (int)samples.size();
+            delta.referenceSamples = (int)reference.size();
+            if (samples.empty() || reference.empty())
+                return delta;
+            const double z = 1.959964;  // the quantile of the normal law for the confidence level
+            double m = (double)samples.size(), n = (double)reference.size();
+            
+            // the U statistic counts the pairs where the sample is slower than the reference, with its normal approximation corrected for ties
+            std::vector<std::pair<double, bool> > all;
+            for (size_t i = 0; i < samples.size(); ++i)
+                all.push_back(std::make_pair(samples[i], true));
+            for (size_t i = 0; i < reference.size(); ++i)
+                all.push_back(std::make_pair(reference[i], false));
+            std::sort(all.begin(), all.end());
+            double ranks = 0.0, ties = 0.0;
+            for (size_t i = 0, j; i < all.size(); i = j) {
+                for (j = i + 1; (j < all.size()) && (all[j].first == all[i].first); ++j) {}
+                double rank = (i + 1 + j) / 2.0, count = (double)(j - i);   // the average rank of the tied samples
+                for (size_t k = i; k < j; ++k)
+                    ranks += all[k].second ? rank : 0.0;
+                ties += count * count * count - count;
+            }
+            double u = ranks - m * (m + 1) / 2;
+            double variance = m * n / 12 * ((m + n + 1) - ties / ((m + n) * (m + n - 1)));
+            if (variance > 0.0)
+                delta.pValue = std::min(1.0, std::erfc(std::max(0.0, std::fabs(u - m * n / 2) - 0.5) / std::sqrt(2 * variance)));
+            
+            // the ratios of the durations are the differences of their logarithms
+            std::vector<double> differences;
+            differences.reserve(samples.size() * reference.size());
+            for (size_t i = 0; i < samples.size(); ++i)
+                for (size_t j = 0; j < reference.size(); ++j)
+                    differences.push_back(std::log(std::max(samples[i], 1e-3)) - std::log(std::max(reference[j], 1e-3)));
+            std::sort(differences.begin(), differences.end());
+            size_t count = differences.size();
+            delta.ratio = std::exp((count % 2) ? differences[count / 2] : ((differences[count / 2 - 1] + differences[count / 2]) / 2.0));
+            double k = std::floor(m * n / 2 - z * std::sqrt(m * n * (m + n + 1) / 12));
+            size_t index = (k > 0.0) ? (size_t)k : 0;
+            delta.lower = std::exp(differences[index]);
+            delta.upper = std::exp(differences[count - 1 - index]);
+            return delta;
+        }
+    };
+    
+    /**
+     TestBenchmarkSamples records the samples of each benchmark, keyed by its path, in a file of JSON lines that other tools can read as well.
+     A run compared to the samples of a previous run fails the benchmarks that are significantly slower by more than the allowed regression,
+     with the whole confidence interval of the change above it (see ntk::TestBenchmarkDelta).
+     @see ntk::TestOptions::benchmarkFile, ntk::TestOptions::compareFile
+     */
+    class TestBenchmarkSamples {
+    public:
+        
+        /** Creates empty samples, allowing the specified regression of the durations in percent. */
+        TestBenchmarkSamples(unsigned int maxRegression = 10) : mMaxRegression(maxRegression) {}
+        
+        /** Loads the samples from the specified file, in addition to the current ones. Returns false if the file can't be read. */
+        bool load(const std::string& fileName) {
+            std::ifstream file(fileName.c_str());
+            if (!file)
+                return false;
+            std::string line;
+            while (std::getline(file, line)) {
+                size_t pos = valueOf(line, "path");
+                size_t times = valueOf(line, "samples_ns");
+                if ((pos >= line.size()) || (line[pos] != '"') || (times >= line.size()) || (line[times] != '['))
+                    continue;
+                std::string path;
+                for (++pos; (pos < line.size()) && (line[pos] != '"'); ++pos)
+                    path += ((line[pos] == '\\') && (pos + 1 < line.size())) ? line[++pos] : line[pos];   // only quotes and backslashes are escaped
+                std::vector<double>& samples = mSamples[path];
+                samples.clear();
+                const char* value = line.c_str() + times + 1;
+                for (char* end; ; value = end + std::strspn(end, ", ")) {
+                    double sample = std::strtod(value, &end);
+                    if (end == value)
+                        break;
+                    samples.push_back(sample);
+                }
+            }
+            return true;
+        }
+        
+        /** Saves the samples to the specified file, with the statistics of the benchmarks. Returns false if the file can't be written. */
+        bool save(const std::string& fileName, const std::vector<TestBenchmarkStats>& benchmarks) const;   // implemented later
+        
+        /** Gets the samples in nanoseconds per iteration of the benchmark with the specified path, or NULL if unknown. */
+        const std::vector<double>* get(const std::string& path) const {
+            std::map<std::string, std::vector<double> >::const_iterator it = mSamples.find(path);
+            return (it == mSamples.end()) ? NULL : &it->second;
+        }
+        
+        /** Sets the samples in nanoseconds per iteration of the benchmark with the specified path. */
+        void set(const std::string& path, const std::vector<double>& samples) { mSamples[path] = samples; }
+        
+        /** Returns true if the specified change is a regression above the allowed regression. */
+        bool isRegression(const TestBenchmarkDelta& delta) const {
+            return delta.isSignificant() && (delta.lower > 1.0 + mMaxRegression / 100.0);
+        }
+        
+        /** Reports a failure if the specified benchmark statistics regressed compared to the samples. */
+        void check(Test& test, const TestBenchmarkStats& stats, TestResult& result) const;  // implemented later
+        
+        /** Prints the change of each of the specified benchmark statistics compared to the samples. */
+        void print(std::ostream& os, const std::vector<TestBenchmarkStats>& benchmarks) const;  // implemented later
+        
+        /** Gets the samples compared by the current run, or NULL if benchmarks are not compared. */
+        static const TestBenchmarkSamples*& active() { static const TestBenchmarkSamples* samples = NULL; return samples; }
+        
+        /** Warns about the settings of the processors adding noise to the measures, when the process may migrate or the frequency may vary (on Linux). */
+        static void warnAboutNoise(std::ostream& os) {
+#ifdef __linux__
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0)
+                return;
+            if (CPU_COUNT(&cpus) > 1)
+                os << "Warning: the benchmarks may migrate between " << CPU_COUNT(&cpus) << " CPUs, pin them to a single CPU (for example with "
+                   << "taskset -c 2) to reduce the noise" << std::endl;
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (!CPU_ISSET(cpu, &cpus))
+                    continue;
+                std::ostringstream fileName;
+                fileName << "/sys/devices/system/cpu/cpu" << cpu << "/cpufreq/scaling_governor";
+                std::ifstream file(fileName.str().c_str());
+                std::string governor;
+                if ((file >> governor) && (governor != "performance")) {
+                    os << "Warning: the frequency of CPU " << cpu << " is scaled by the " << governor << " governor, use the performance governor "
+                       << "(for example with cpupower frequency-set -g performance) to reduce the noise" << std::endl;
+                    break;  // the governor is usually the same for all CPUs
+                }
+            }
+            std::ifstream turbo("/sys/devices/system/cpu/intel_pstate/no_turbo");
+            int noTurbo = 1;
+            if ((turbo >> noTurbo) && (noTurbo == 0))
+                os << "Warning: turbo boost is enabled, disable it (echo 1 > /sys/devices/system/cpu/intel_pstate/no_turbo) to reduce the noise" << std::endl;
+#else
+            (void)os;
+#endif
+        }
+        
+    private:
+        // gets the position of the value of the specified key in a JSON line, or npos if the line has no such key
+        static size_t valueOf(const std::string& line, const std::string& key) {
+            size_t pos = line.find("\"" + key + "\"");
+            if (pos == std::string::npos)
+                return pos;
+            pos = line.find_first_not_of(" \t", pos + key.size() + 2);
+            if ((pos == std::string::npos) || (line[pos] != ':'))
+                return std::string::npos;
+            return line.find_first_not_of(" \t", pos + 1);
+        }
+        
+        std::map<std::string, std::vector<double> > mSamples;   // the samples, by benchmark path
+        unsigned int mMaxRegression;                            // the regression allowed in percent
+    };
+    
+    /**
+     TestChanges tells which tests are affected by a set of changed files, from the files in which the tests are declared (see ntk::TestDescriptor).
+     The changed files are read from a text file with one path per line, such as the output of "git diff --name-only". A dependency map may also
+     be loaded, in the format of make rules ("target: dependencies...") as written by the -MD option of GCC and Clang: the tests declared in a file
+     listed by a rule are then affected by the changes of any other file of the rule. Paths are compared by their last components, so a path
+     relative to the root of the repository matches the path of the same file given to the compiler.
+     @see TestOptions::changedFilesFile
+     */
+    class TestChanges {
+    public:
+        
+        /** Loads the changed files from the specified file, in addition to the current ones. Returns false if the file can't be read. */
+        bool load(const std::string& fileName) {
+            std::ifstream file(fileName.c_str());
+            if (!file)
+                return false;
+            std::string path;
+            while (std::getline(file, path)) {
+                path = normalize(path);
+                if (!path.empty())
+                    mChanged.insert(std::make_pair(baseName(path), path));
+            }
+            update();
+            return true;
+        }
+        
+        /** Loads the dependencies from the specified file of make rules, in addition to the current ones. Returns false if the file can't be read. */
+        bool loadDependencies(const std::string& fileName) {
+            std::ifstream file(fileName.c_str());
+            if (!file)
+                return false;
+            std::string line;
+            std::vector<std::string> rule;
+            while (std::getline(file, line)) {
+                std::istringstream ss(line);
+                std::string path;
+                while (ss >> path) {
+                    if ((path == "\\") || (path == ":"))
+                        continue;
+                    if (path[path.size() - 1] == ':')
+                        path.erase(path.size() - 1);    // a target
+                    rule.push_back(normalize(path));
+                }
+                size_t last = line.find_last_not_of(" \t\r");
+                bool continued = (last != std::string::npos) && (line[last] == '\\');
+                if (!continued && !rule.empty()) {
+                    mRules.push_back(rule);
+                    rule.clear();
+                }
+            }
+            if (!rule.empty())
+                mRules.push_back(rule);
+            update();
+            return true;
+        }
+        
+        /** 
+         Returns true if the specified file has changed, or any other file of a dependency rule listing it. The answer is cached by file name 
+         pointer, as the tests declared in a file share the same name.
+         */
+        bool affects(const char* file) const {
+            std::map<const char*, bool>::const_iterator it = mAnswers.find(file);
+            if (it == mAnswers.end())
+                it = mAnswers.insert(std::make_pair(file, contains(mAffected, normalize(file)))).first;
+            return it->second;
+        }
+        
+        /** Returns true if the specified paths designate the same file, i.e. if the shortest one is made of the last components of the other. */
+        static bool isSameFile(const std::string& path, const std::string& other) {
+            const std::string& shortest = (path.size() <= other.size()) ? path : other;
+            const std::string& longest = (path.size() <= other.size()) ? other : path;
+            size_t start = longest.size() - shortest.size();
+            return !shortest.empty() && (longest.compare(start, std::string::npos, shortest) == 0) && 
+                   ((start == 0) || (longest[start - 1] == '/'));
+        }
+        
+    private:
+        // trims a path and removes its leading "./", using '/' as separator
+        static std::string normalize(std::string path) {
+            std::replace(path.begin(), path.end(), '\\', '/');
+            size_t begin = path.find_first_not_of(" \t\r");
+            size_t end = path.find_last_not_of(" \t\r");
+            path = (begin == std::string::npos) ? "" : path.substr(begin, end - begin + 1);
+            while (path.compare(0, 2, "./") == 0)
+                path.erase(0, 2);
+            return path;
+        }
+        
+        // gets the last component of a path, the same file having the same base name in all its paths
+        static std::string baseName(const std::string& path) {
+            size_t separator = path.rfind('/');
+            return (separator == std::string::npos) ? path : path.substr(separator + 1);
+        }
+        
+        // returns true if the specified files, indexed by their base names, contain the specified file
+        static bool contains(const std::multimap<std::string, std::string>& files, const std::string& file) {
+            typedef std::multimap<std::string, std::string>::const_iterator Iterator;
+            std::pair<Iterator, Iterator> range = files.equal_range(baseName(file));
+            for (Iterator it = range.first; it != range.second; ++it)
+                if (isSameFile(it->second, file))
+                    return true;
+            return false;
+        }
+        
+        // computes the affected files once the changes or the rules are loaded: the changed files and the files of the rules listing one of them
+        void update() {
+            mAffected = mChanged;
+            mAnswers.clear();
+            for (std::vector<std::vector<std::string> >::const_iterator rule = mRules.begin(); rule != mRules.end(); ++rule) {
+                std::vector<std::string>::const_iterator it = rule->begin();
+                while ((it != rule->end()) && !contains(mChanged, *it))
+                    ++it;
+                if (it == rule->end())
+                    continue;
+                for (it = rule->begin(); it != rule->end(); ++it)
+                    mAffected.insert(std::make_pair(baseName(*it), *it));
+            }
+        }
+        
+        std::multimap<std::string, std::string> mChanged;   // the changed files, by base name
+        std::vector<std::vector<std::string> > mRules;      // the files of each dependency rule
+        std::multimap<std::string, std::string> mAffected;  // the changed files and the files of the rules listing one of them, by base name
+        mutable std::map<const char*, bool> mAnswers;       // whether the files already asked about are affected, by name pointer
+    };
+    
+    /**
+     TestFilter selects the tests to run according to the filter and exclude patterns of a ntk::TestOptions object.
+     Patterns are matched against the path of the tests (for example Suite/SubSuite/Test), where '*' matches any characters but '/', '**' matches any
+     characters and '?' matches any single character. A test is selected if its path or the path of one of its parent suites matches a filter pattern 
+     (or if there is no filter pattern), and neither matches an exclude pattern. If changed files are given, only the test cases affected by the 
+     changes are selected (see ntk::TestChanges), as well as the test cases that are not declared with the macros since their file is unknown. 
+     A suite is selected if any of its tests is selected.
+     The selection is computed once when the filter is created, so checking whether a test is selected does not depend on the tree depth.
+     
+     When the tests are split in shards, the selected test cases are then partitioned deterministically so each test case belongs to exactly one shard.
+     Test cases are distributed in a round robin fashion, or if recorded durations are available, dealt longest first to the shard with the lowest 
+     total duration so that all shards take about the same time to run (test cases with no recorded duration count for the average duration).
+     
+     The filter also tracks the progress of the run: some selected tests may be prioritized (such as the tests that failed during the last run) to be
+     run first, and the whole run is stopped after the first failure in fail fast mode.
+     @see TestOptions::filters
+     @see TestOptions::shardCount
+     @see TestOptions::failFast
+     */
+    class TestFilter {
+    public:
+        
+        /** 
+         Creates a filter selecting among the specified tests with the patterns of the specified options.
+         The specified recorded durations are used to balance the shards, if the tests are split in shards. If the tests stand for the declared tests 
+         (see ntk::TestTree), the files of the tests are found from the specified tests of the tree instead of creating the declared tests.
+         */
+        TestFilter(const std::vector<Test*>& tests, const TestOptions& options, const TestDurations& durations = TestDurations(), 
+                   const TestRegistry::Tests* declared = NULL)
+        : mFilters(options.filters), mExcludes(options.excludes), 
+          mSelectAll(options.filters.empty() && options.excludes.empty() && (options.shardCount <= 1) && options.changedFilesFile.empty()),
+          mFailFast(options.failFast), mStopped(false)
+        {
+            if (mSelectAll)
+                return;
+            
+            TestChanges changes;
+            if (!options.changedFilesFile.empty() && changes.load(options.changedFilesFile)) {
+                if (!options.dependenciesFile.empty())
+                    changes.loadDependencies(options.dependenciesFile);
+                std::vector<const TestDescriptor*> descriptors = TestRegistry::descriptors();
+                for (std::vector<const TestDescriptor*>::const_iterator it = descriptors.begin(); it != descriptors.end(); ++it) {
+                    if (((*it)->kind != TestDescriptor::TestCase) && ((*it)->kind != TestDescriptor::ParameterizedTest))
+                        continue;
+                    if (declared == NULL) {
+                        mAffected[&(*it)->instance()] = changes.affects((*it)->file);
+                        continue;
+                    }
+                    TestRegistry::Tests::const_iterator test = declared->find((*it)->instance);
+                    if (test != declared->end())
+                        mAffected[test->second] = changes.affects((*it)->file);
+                }
+            }   // otherwise all the tests are considered affected, rather than running none
+            select(tests, "", mFilters.empty());
+            if (options.shardCount > 1)
+                shard(tests, options.shardIndex, options.shardCount, durations);
+        }
+        
+        /** Returns true if the specified test is selected. */
+        bool isSelected(const Test* test) const {
+            return (mSelectAll || (mSelection.find(test) != mSelection.end()));
+        }
+        
+        /** 
+         Prioritizes the selected test cases among the specified tests that are part of the specified failed tests, as well as their suites.
+         Returns true if any test case has been prioritized, so the tests should be reordered (see TestSuite::moveFirst()).
+         */
+        bool prioritize(const std::vector<Test*>& tests, const TestFailures& failures) {
+            mPriority.clear();
+            return prioritize(tests, "", failures);
+        }
+        
+        /** Returns true if the specified test should be run, i.e. if it is selected and the run has not been stopped. */
+        bool shouldRun(const Test* test) const { return !mStopped && isSelected(test); }
+        
+        /** Returns true if the specified test is prioritized. */
+        bool isPrioritized(const Test* test) const { return (mPriority.find(test) != mPriority.end()); }
+        
+        /** Gets the prioritized test cases and their suites. */
+        const std::set<const Test*>& prioritized() const { return mPriority; }
+        
+        /** 
+         Records that the specified test case has been run, and whether it has failed. 
+         Returns true if the run must be stopped, i.e. the test failed in fail fast mode.
+         */
+        bool testRan(const Test* test, bool failed) {
+#ifndef DO_NOT_USE_THREADS
+            std::lock_guard<std::mutex> lock(mMutex);
+#endif
+            mRun.insert(test);
+            if (failed)
+                mFailed.insert(test);
+            mStopped = mStopped || (failed && mFailFast);
+            return mStopped;
+        }
+        
+        /** Returns true if the specified test case has been run. */
+        bool wasRun(const Test* test) const {
+#ifndef DO_NOT_USE_THREADS
+            std::lock_guard<std::mutex> lock(mMutex);
+#endif
+            return (mRun.find(test) != mRun.end());
+        }
+        
+        /** Returns true if the specified test case has been run and has failed. */
+        bool hasFailed(const Test* test) const {
+#ifndef DO_NOT_USE_THREADS
+            std::lock_guard<std::mutex> lock(mMutex);
+#endif
+            return (mFailed.find(test) != mFailed.end());
+        }
+        
+        /** Returns true if the specified test should be run by the current run, if any. */
+        static bool accepts(const Test* test) {
+            return ((active() == NULL) || active()->shouldRun(test));
+        }
+        
+        /** Returns true if the specified test is prioritized by the current run, if any. */
+        static bool prioritizes(const Test* test) {
+            return ((active() != NULL) && active()->isPrioritized(test));
+        }
+        
+        /** Returns true if the specified path matches the specified pattern. */
+        static bool matches(const char* pattern, const char* path) {
+            for (; *pattern != '\0'; ++pattern, ++path) {
+                if (*pattern == '*') {
+                    bool any = (pattern[1] == '*');     // "**" also matches '/'
+                    const char* rest = pattern + (any ? 2 : 1);
+                    for (;; ++path) {
+                        if (matches(rest, path))
+                            return true;
+                        if ((*path == '\0') || (!any && (*path == '/')))
+                            return false;
+                    }
+                }
+                if ((*path == '\0') || ((*pattern != '?') && (*pattern != *path)) || ((*pattern == '?') && (*path == '/')))
+                    return false;
+            }
+            return (*path == '\0');
+        }
+        
+        /** Gets the filter of the current run, or NULL if tests are not being run by Test::runAll(). */
+        static TestFilter*& active() { static TestFilter* filter = NULL; return filter; }
+        
+    private:
+        // returns true if the path matches one of the patterns
+        static bool matchesAny(const std::vector<std::string>& patterns, const std::string& path) {
+            for (std::vector<std::string>::const_iterator it = patterns.begin(); it != patterns.end(); ++it)
+                if (matches(it->c_str(), path.c_str()))
+                    return true;
+            return false;
+        }
+        
+        // selects the tests matching the patterns, returns true if any test has been selected
+        bool select(const std::vector<Test*>& tests, const std::string& parentPath, bool included) {
+            bool selected = false;
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+                if (matchesAny(mExcludes, path))
+                    continue;
+                
+                bool testIncluded = included || matchesAny(mFilters, path);
+                if ((*it)->isSuite() ? select(static_cast<TestSuite*>(*it)->tests(), path, testIncluded) : (testIncluded && isAffected(*it))) {
+                    mSelection.insert(*it);
+                    selected = true;
+                }
+            }
+            return selected;
+        }
+        
+        // returns true if the specified test case, or the test it is a case of, is affected by the changes or is not declared with the macros
+        bool isAffected(const Test* test) const {
+            for (; test != NULL; test = test->parent()) {
+                std::map<const Test*, bool>::const_iterator it = mAffected.find(test);
+                if (it != mAffected.end())
+                    return it->second;
+            }
+            return true;
+        }
+        
+        // a selected test case with its path, in declaration order
+        struct Leaf {
+            Leaf(const Test* theTest, const std::string& thePath, size_t theIndex) : test(theTest), path(thePath), index(theIndex), weight(0) {}
+            const Test* test;
+            std::string path;
+            size_t index;
+            long long weight;
+            bool operator<(const Leaf& other) const { return (weight != other.weight) ? (weight > other.weight) : (index < other.index); }
+        };
+        
+        // collects the selected test cases
+        void collect(const std::vector<Test*>& tests, const std::string& parentPath, std::vector<Leaf>& leaves) const {
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                if (!isSelected(*it))
+                    continue;
+                std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+                if ((*it)->isSuite())
+                    collect(static_cast<TestSuite*>(*it)->tests(), path, leaves);
+                else
+                    leaves.push_back(Leaf(*it, path, leaves.size()));
+            }
+        }
+        
+        // keeps only the selected test cases of the specified shard
+        void shard(const std::vector<Test*>& tests, unsigned int index, unsigned int count, const TestDurations& durations) {
+            std::vector<Leaf> leaves;
+            collect(tests, "", leaves);
+            
+            std::set<const Test*> kept;
+            if (durations.empty()) {
+                for (size_t i = index; i < leaves.size(); i += count)
+                    kept.insert(leaves[i].test);
+            } else {
+                for (std::vector<Leaf>::iterator it = leaves.begin(); it != leaves.end(); ++it)
+                    it->weight = durations.estimate(it->path);
+                
+                // longest first on the least loaded shard, ties broken by declaration order
+                std::sort(leaves.begin(), leaves.end());
+                std::vector<long long> loads(count, 0);
+                for (std::vector<Leaf>::iterator it = leaves.begin(); it != leaves.end(); ++it) {
+                    size_t target = std::min_element(loads.begin(), loads.end()) - loads.begin();
+                    loads[target] += it->weight;
+                    if (target == index)
+                        kept.insert(it->test);
+                }
+            }
+            
+            mSelection.clear();
+            prune(tests, kept);
+        }
+        
+        // selects the kept test cases and their parent suites, returns true if any test has been selected
+        bool prune(const std::vector<Test*>& tests, const std::set<const Test*>& kept) {
+            bool selected = false;
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                if ((*it)->isSuite() ? prune(static_cast<TestSuite*>(*it)->tests(), kept) : (kept.find(*it) != kept.end())) {
+                    mSelection.insert(*it);
+                    selected = true;
+                }
+            }
+            return selected;
+        }
+        
+        // prioritizes the selected tests that failed and their suites, returns true if any test has been prioritized
+        bool prioritize(const std::vector<Test*>& tests, const std::string& parentPath, const TestFailures& failures) {
+            bool prioritized = false;
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                if (!isSelected(*it))
+                    continue;
+                std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+                bool testPrioritized;
+                if ((*it)->isSuite())
+                    testPrioritized = prioritize(static_cast<TestSuite*>(*it)->tests(), path, failures);
+                else
+                    testPrioritized = failures.contains(path);
+                if (testPrioritized) {
+                    mPriority.insert(*it);
+                    prioritized = true;
+                }
+            }
+            return prioritized;
+        }
+        
+        std::vector<std::string> mFilters;  // the patterns of tests to run
+        std::vector<std::string> mExcludes; // the patterns of tests not to run
+        bool mSelectAll;                    // true if there is no pattern
+        std::set<const Test*> mSelection;   // the selected tests and suites
+        std::map<const Test*, bool> mAffected;  // whether each test declared with the macros is affected by the changed files, if any
+        std::set<const Test*> mPriority;    // the prioritized tests and their suites
+        bool mFailFast;                     // true to stop the run after the first failure
+        bool mStopped;                      // true if the run has been stopped
+        std::set<const Test*> mRun;         // the test cases that have been run
+        std::set<const Test*> mFailed;      // the test cases that have failed
+#ifndef DO_NOT_USE_THREADS
+        mutable std::mutex mMutex;          // protects the test cases run, which the watchdog records from its thread when a test times out
+#endif
+    };
+    
+#pragma mark -
+#pragma mark Fixture definition
+    
+    /**
+     A TestFixture is a basic class encapsulating a set of objects that serves as a base for a set of tests.
+     The setup/teardown mechanism of a fixture is implemented through the use use of standard c++ constructor and destructor.
+     You just have to declare a fixture class on the stack at the beginning of a test to use it.
+     
+     The convenience macros FIXTURE, SETUP, TEARDOWN and USE_FIXTURE are meant to simplify declaration and usage of test fixtures.
+     A fixture declaring a RESET method is pooled: instead of being destroyed at the end of a test, it is kept by the thread that used it and reset to
+     be used by the next test, so that costly resources are reused (see ntk::TestFixturePool).
+     @see ntk::Test
+     */
+    class TestFixture {
+    public:
+        
+        /** Creates the fixture, used as the setup method of the fixture. */
+        TestFixture() {}
+        
+        /** Destroys the fixture, used as the teardown method of the fixture. */
+        virtual ~TestFixture() = 0;
+        
+    private:
+        // private copy constructor and assign operator as a fixture must not be copied
+        TestFixture(const TestFixture&);
+        const TestFixture& operator=(const TestFixture&);
+    };
+    
+    inline TestFixture::~TestFixture() {}   // pure virtual destructor implementation
+    
+    /**
+     TestFixturePool keeps the pooled fixtures of a class that are not in use, one pool per thread so that no synchronization is needed.
+     A fixture class is pooled if it declares a RESET method, which is called instead of destroying the fixture and setting up a new one. The 
+     fixtures of the pool are only destroyed when the thread exits.
+     @see ntk::TestFixture
+     */
+    template <class T>
+    class TestFixturePool {
+    public:
+        
+        /** Gets a fixture from the pool of the calling thread and resets it, or sets up a new fixture if none is available. */
+        static T* acquire() {
+            Pool& pool = threadPool();
+            if (pool.fixtures.empty()) {
+                pool.fixtures.reserve(pool.count + 1);  // so that releasing a fixture never allocates memory nor throws
+                T* fixture = new T();
+                ++pool.count;
+                return fixture;
+            }
+            T* fixture = pool.fixtures.back();
+            pool.fixtures.pop_back();
+#ifndef DO_NOT_USE_EXCEPTIONS
+            try {
+                fixture->resetTestFixture();
+            } catch (...) {
+                --pool.count;
+                delete fixture;
+                throw;
+            }
+#else
+            fixture->resetTestFixture();
+#endif
+            return fixture;
+        }
+        
+        /** Gives back a fixture to the pool of the calling thread, so that it can be reused by another test. */
+        static void release(T* fixture) { threadPool().fixtures.push_back(fixture); }
+        
+    private:
+        // the fixtures of a thread that are not in use
+        struct Pool {
+            Pool() : count(0) {}
+            ~Pool() {
+                for (typename std::vector<T*>::iterator it = fixtures.begin(); it != fixtures.end(); ++it)
+                    delete *it;
+            }
+            std::vector<T*> fixtures;
+            size_t count;       // the number of fixtures created by the thread and not destroyed
+        };
+        
+        // gets the pool of the calling thread
+        static Pool& threadPool() {
+#ifndef DO_NOT_USE_THREADS
+            static thread_local Pool pool;
+#else
+            static Pool pool;
+#endif
+            return pool;
+        }
+    };
+    
+    /**
+     A TestFixtureInstance is the fixture used by a test (see USE_FIXTURE). A fixture is set up for each test and destroyed at the end of the test, 
+     unless the fixture class is pooled, then it is taken from the pool of the thread and given back at the end of the test.
+     @see ntk::TestFixturePool
+     */
+    template <class T, class Pooled = void>
+    class TestFixtureInstance {
+    public:
+        /** Gets the fixture. */
+        T& get() { return mFixture; }
+        
+    private:
+        T mFixture;
+    };
+    
+    template <class T>
+    class TestFixtureInstance<T, typename T::PooledTestFixture> {
+    public:
+        /** Gets a fixture from the pool. */
+        TestFixtureInstance() : mFixture(TestFixturePool<T>::acquire()) {}
+        
+        /** Gives back the fixture to the pool. */
+        ~TestFixtureInstance() { TestFixturePool<T>::release(mFixture); }
+        
+        /** Gets the fixture. */
+        T& get() { return *mFixture; }
+        
+    private:
+        T* mFixture;
+        
+        // private copy constructor and assign operator as a fixture must not be copied
+        TestFixtureInstance(const TestFixtureInstance&);
+        const TestFixtureInstance& operator=(const TestFixtureInstance&);
+    };
+    
+#pragma mark -
+#pragma mark Test failure recording
+    
+    /**
+     A TestCondition object describes the condition that provoked a test failure, without formatting it.
+     It only references the expressions of the check and its operand values, which are formatted when the condition is printed. This way reporting
+     a failure does not allocate any memory until it is actually rendered, but a condition must not be used after the check that created it.
+     */
+    class TestCondition {
+    public:
+        
+        /** Creates a condition made of the specified text, followed by the specified detail if any. */
+        TestCondition(const char* text, const char* detail = NULL) 
+        : mText(text), mDetail(detail), mMessage(NULL), mOperandCount(0) 
+        { mDescription.print = NULL; }
+        
+        /** Creates a condition made of 2 operands expressions and values, separated by the specified operator. */
+        template <typename X, typename Y>
+        TestCondition(const char* x, const X& xValue, const char* op, const char* y, const Y& yValue)
+        : mText(NULL), mDetail(NULL), mMessage(NULL), mOperandCount(2)
+        {
+            mDescription.print = NULL;
+            setOperand(0, x, xValue);
+            setOperand(1, y, yValue);
+            mOperators[0] = op;
+        }
+        
+        /** Creates a condition made of 3 operands expressions and values, separated by the specified operators. */
+        template <typename X, typename Y, typename Z>
+        TestCondition(const char* x, const X& xValue, const char* op1, const char* y, const Y& yValue, const char* op2, const char* z, const Z& zValue)
+        : mText(NULL), mDetail(NULL), mMessage(NULL), mOperandCount(3)
+        {
+            mDescription.print = NULL;
+            setOperand(0, x, xValue);
+            setOperand(1, y, yValue);
+            setOperand(2, z, zValue);
+            mOperators[0] = op1;
+            mOperators[1] = op2;
+        }
+        
+        /** Sets the explanation message of the condition, which is not copied. Returns the condition. */
+        TestCondition& note(const char* message) { mMessage = message; return *this; }
+        
+        /** 
+         Sets a description of the condition printed after its operands with its stream operator, which is neither copied nor formatted until the 
+         condition is printed. Returns the condition.
+         */
+        template <typename T>
+        TestCondition& describe(const T& description) {
+            mDescription.expression = NULL;
+            mDescription.value = &description;
+            mDescription.print = &printValue<T>;
+            return *this;
+        }
+        
+        /** Prints the condition to the specified stream. */
+        void print(std::ostream& os) const {
+            if (mOperandCount == 0) {
+                os << mText;
+                if (mDetail != NULL)
+                    os << mDetail;
+            }
+            for (int i = 0; i < mOperandCount; ++i) {
+                if (i != 0)
+                    os << " " << mOperators[i - 1] << " ";
+                os << mOperands[i].expression << " (";
+                mOperands[i].print(os, mOperands[i].value);
+                os << ")";
+            }
+            if (mDescription.print != NULL)
+                mDescription.print(os, mDescription.value);
+            if ((mMessage != NULL) && (*mMessage != '\0'))
+                os << ", Note: " << mMessage;
+        }
+        
+        /** Gets the condition as a string. */
+        std::string str() const {
+            std::ostringstream ss;
+            print(ss);
+            return ss.str();
+        }
+        
+    private:
+        // an operand of the check, with the function printing its value
+        struct Operand {
+            const char* expression;
+            const void* value;
+            void (*print)(std::ostream& os, const void* value);
+        };
+        
+        // prints a value of the specified type
+        template <typename T>
+        static void printValue(std::ostream& os, const void* value) {
+            os << *static_cast<const T*>(value);
+        }
+        
+        // sets the expression and value of an operand
+        template <typename T>
+        void setOperand(int index, const char* expression, const T& value) {
+            mOperands[index].expression = expression;
+            mOperands[index].value = &value;
+            mOperands[index].print = &printValue<T>;
+        }
+        
+        const char* mText;          // the text of the condition, if it has no operand
+        const char* mDetail;        // the detail following the text, NULL if none
+        const char* mMessage;       // the explanation message, NULL if none
+        int mOperandCount;          // the number of operands
+        Operand mOperands[3];       // the operands
+        const char* mOperators[2];  // the operators between the operands
+        Operand mDescription;       // the description of the condition, not printed if its print function is NULL
+    };
+    
+    /**
+     TestStrings interns strings: each distinct string is copied once in an arena, and the same copy is given for all the equal strings, so that 
+     records repeating a few strings (such as the file and test names of the failures) only keep pointers. The strings are kept until the 
+     TestStrings object is destroyed.
+     */
+    class TestStrings {
+    public:
+        
+        /** Creates an empty set of strings. */
+        TestStrings() {}
+        
+        /** Gets the interned copy of the specified string. */
+        const char* intern(const char* text) {
+#ifndef DO_NOT_USE_THREADS
+            std::lock_guard<std::mutex> lock(mMutex);
+#endif
+            std::set<const char*, Less>::const_iterator it = mStrings.find(text);
+            if (it != mStrings.end())
+                return *it;
+            TestAllocations::Pause pause;   // not part of the test reporting the string
+            const char* copy = mArena.copy(text);
+            mStrings.insert(copy);
+            return copy;
+        }
+        
+        /** Gets the strings of the process, which may be interned from any thread. */
+        static TestStrings& shared() { static TestStrings strings; return strings; }
+        
+    private:
+        // orders the strings by their characters
+        struct Less {
+            bool operator()(const char* text, const char* other) const { return (std::strcmp(text, other) < 0); }
+        };
+        
+        TestArena mArena;                       // the characters of the strings
+        std::set<const char*, Less> mStrings;   // the interned strings
+#ifndef DO_NOT_USE_THREADS
+        std::mutex mMutex;                      // protects the strings
+#endif
+        
+        // private copy constructor and assign operator as the strings can't be copied
+        TestStrings(const TestStrings&);
+        const TestStrings& operator=(const TestStrings&);
+    };
+    
+    /**
+     A TestFailure object records the context information about a test failure.
+     C++ macros are used to provide the name of the file and the line number where the failure occurred.
+     
+     Failures reported by the assertion macros only reference their context information, so they must be printed or copied while being reported
+     (i.e. during TestResult::addFailure()). Copying a failure renders its condition, so the copy owns its condition and may be kept, while its
+     file and test name are interned (see ntk::TestStrings) as they are shared by many failures.
+     The context information was previously read from public data members, it is now read from the accessors of the same names.
+     */
+    class TestFailure {
+    public:
+        
+        /** Creates a new failure with the given context information. */
+        TestFailure(const std::string& theCondition, const std::string& theTestName, const std::string& theFileName, int theLine)
+        : mCondition(NULL), mTestName(TestStrings::shared().intern(theTestName.c_str())), mFileName(TestStrings::shared().intern(theFileName.c_str())),
+          mLine(theLine), mInterned(true), mConditionText(theCondition)
+        {}
+        
+        /** Creates a new failure referencing the given context information, which is neither copied nor formatted. */
+        TestFailure(const TestCondition& theCondition, const char* theTestName, const char* theFileName, int theLine)
+        : mCondition(&theCondition), mTestName(theTestName), mFileName(theFileName), mLine(theLine), mInterned(false)
+        {}
+        
+        /** Creates a copy of the specified failure, owning its condition. */
+        TestFailure(const TestFailure& other)
+        : mCondition(NULL), mTestName(other.internedTestName()), mFileName(other.internedFileName()), mLine(other.mLine), mInterned(true),
+          mConditionText(other.condition())
+        {}
+        
+        /** Assigns a copy of the specified failure, owning its condition. */
+        TestFailure& operator=(const TestFailure& other) {
+            if (this != &other) {
+                std::string condition = other.condition();
+                mConditionText.swap(condition);
+                mTestName = other.internedTestName();
+                mFileName = other.internedFileName();
+                mCondition = NULL;
+                mLine = other.mLine;
+                mInterned = true;
+            }
+            return *this;
+        }
+        
+        /** Gets the condition that provoked the failure. */
+        std::string condition() const { return (mCondition != NULL) ? mCondition->str() : mConditionText; }
+        
+        /** Prints the condition that provoked the failure to the specified stream, without intermediate string. */
+        void printCondition(std::ostream& os) const {
+            if (mCondition != NULL)
+                mCondition->print(os);
+            else
+                os << mConditionText;
+        }
+        
+        /** Gets the name of the test that failed. */
+        const char* testName() const { return mTestName; }
+        
+        /** Gets the name of the file in which the test failed. */
+        const char* fileName() const { return mFileName; }
+        
+        /** Gets the line number at which the failure occured. */
+        int line() const { return mLine; }
+        
+        /** Stream output operator. */
+        friend std::ostream& operator<<(std::ostream& os, const TestFailure& failure) {
+            os << failure.fileName() << "(" << failure.line() << "): Failure: \"";
+            failure.printCondition(os);
+            return (os << "\"");
+        }
+        
+    private:
+        // gets the test and file names for a copy of the failure
+        const char* internedTestName() const { return mInterned ? mTestName : TestStrings::shared().intern(mTestName); }
+        const char* internedFileName() const { return mInterned ? mFileName : TestStrings::shared().intern(mFileName); }
+        
+        const TestCondition* mCondition;    // the referenced condition, NULL if owned
+        const char* mTestName;              // the test name, referenced or interned
+        const char* mFileName;              // the file name, referenced or interned
+        int mLine;                          // the line number
+        bool mInterned;                     // true if the names are interned, so they can be shared by the copies
+        std::string mConditionText;         // the owned condition
+    };        
+    
+#pragma mark -
+#pragma mark Test result processing
+    
+    /** A TestTiming object records the time spent running a test. */
+    struct TestTiming {
+        
+        /** Creates a new timing record with the given information, the path having to outlive the record (e.g. interned, see ntk::TestStrings). */
+        TestTiming(const char* thePath, TestType theType, long long theDuration, long long theExclusiveDuration)
+        : type(theType), duration(theDuration), exclusiveDuration(theExclusiveDuration), mPath(thePath)
+        {}
+        
+        /** Gets the path of the test, i.e. the names of its parent suites and its own name separated by "/". */
+        std::string path() const { return mPath; }
+        
+        TestType type;              ///< The type of the test.
+        long long duration;         ///< The time spent running the test in nanoseconds, including its sub tests.
+        long long exclusiveDuration;///< The time spent running the test in nanoseconds, excluding its sub tests.
+        
+    private:
+        const char* mPath;          // the path of the test
+    };
+    
+    /** A TestBenchmarkStats object records the measures of a benchmark. All times are expressed in nanoseconds per iteration of the measured code. */
+    struct TestBenchmarkStats {
+        
+        /** Creates empty benchmark statistics. */
+        TestBenchmarkStats()
+        : iterations(0), samples(0), min(0), median(0), p99(0), mean(0), stddev(0), mPath("")
+        {}
+        
+        /** Gets the path of the benchmark (set by TestResult). */
+        std::string path() const { return mPath; }
+        
+        long long iterations;   ///< The number of iterations of the measured code per sample.
+        int samples;            ///< The number of samples measured.
+        double min;             ///< The fastest sample.
+        double median;          ///< The median sample, the most representative measure.
+        double p99;             ///< The 99th percentile sample.
+        double mean;            ///< The mean of all samples.
+        double stddev;          ///< The standard deviation of all samples.
+        std::vector<double> sampleTimes;    ///< The samples in increasing order, to compare them to the samples of another run.
+        
+    private:
+        const char* mPath;      // the path of the benchmark, interned for the whole run (see ntk::TestStrings)
+        friend class TestResult;// sets the path
+    };
+    
+    /**
+     The TestResult class is used to process the test results.
+     By deriving from this class you can process these results by overriding methods that are called at various stages of the testing process.
+     This base class only provides timing and records of executed tests and failures. Subclasses overriding testBegins() and testEnds() must call the
+     base class implementation.
+     @see ntk::OStreamTestResult
+     */
+    class TestResult {
+    public:
+        
+        /** Creates a new test result. */
+        TestResult() 
+        : mTestCount(0), mFailureCount(0), mFailedTestCount(0), mCaseFailureCount(0), mElapsedSeconds(0), mElapsedTime(0), mStartTime(0)
+        {}
+        
+        /** Destroys the test result. */
+        virtual ~TestResult() {}
+        
+        /** This method is called before running all tests. */
+        virtual void allTestsBegin() {
+            mStartTime = TestClock::now();
+        }
+        
+        /** This method is called after all tests have been run. */
+        virtual void allTestsEnd() {
+            mElapsedTime = TestClock::now() - mStartTime;
+            mElapsedSeconds = (int)(mElapsedTime / 1000000000ll);
+        }
+        
+        /** This method is called each time a test begins. */
+        virtual void testBegins(Test* test) {
+            if (!test->isSuite())
+                mCaseFailureCount = mFailureCount;
+            mPath.push_back(test);
+            mPathNames.push_back(internPath(test));
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            if (!test->isSuite()) {
+                ++mTestCount;
+                mFailedTestCount += (mFailureCount > mCaseFailureCount) ? 1 : 0;   // a test may report several failures
+            }
+            mTimings.push_back(TestTiming(currentPath(), test->type(), test->duration(), test->exclusiveDuration()));
+            if (!mPath.empty()) {
+                mPath.pop_back();
+                mPathNames.pop_back();
+            }
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            ++mFailureCount;
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            mBenchmarks.push_back(stats);
+            mBenchmarks.back().mPath = currentPath();
+        }
+        
+        /** This method is called when a test case ends, with its heap allocations if they are tracked (see ntk::TestAllocations). */
+        virtual void allocationResult(Test* test, const TestAllocationStats& stats) {
+            mAllocations.push_back(stats);
+            mAllocations.back().mPath = currentPath();
+        }
+        
+        /** This method is called when a test case or the samples of a benchmark have been measured, with their hardware events (see ntk::TestCounters). */
+        virtual void counterResult(Test* test, const TestCounterStats& stats) {
+            mCounters.push_back(stats);
+            mCounters.back().mPath = currentPath();
+        }
+        
+        /** This method is called when a test case ends, once per assertion site it checked if checks are profiled (see ntk::TestCheckProfile). */
+        virtual void checkResult(Test* test, const TestCheckStats& stats) {
+            mChecks.push_back(stats);
+            mChecks.back().mPath = currentPath();
+        }
+        
+        /** 
+         This method is called before the tests reported may be run again or destroyed (for example the cases of a parameterized test), and 
+         returns once their results have been processed. Only results processed asynchronously need to override it (see ntk::AsyncTestResult).
+         */
+        virtual void drain() {}
+        
+        /** Gets the number of test failures. */
+        int failures() const { return mFailureCount; }
+        
+        /** Gets the number of test cases that failed, each one having reported one or more failures. */
+        int failedTests() const { return mFailedTestCount; }
+        
+        /** Gets the elapsed time in seconds to run all the tests (set after all tests have been run). */
+        int elapsedSeconds() const { return mElapsedSeconds; }
+        
+        /** Gets the elapsed time in nanoseconds to run all the tests (set after all tests have been run). */
+        long long elapsedTime() const { return mElapsedTime; }
+        
+        /** Gets the timings of all the tests and suites that have ended, in the order they ended. */
+        const std::vector<TestTiming>& timings() const { return mTimings; }
+        
+        /** Gets the statistics of all the benchmarks that have been run. */
+        const std::vector<TestBenchmarkStats>& benchmarks() const { return mBenchmarks; }
+        
+        /** Gets the heap allocations of all the test cases that have been run, if allocations are tracked. */
+        const std::vector<TestAllocationStats>& allocations() const { return mAllocations; }
+        
+        /** Gets the hardware events of all the test cases and benchmarks that have been run, if they are counted. */
+        const std::vector<TestCounterStats>& counters() const { return mCounters; }
+        
+        /** Gets the checks of the assertion sites of all the test cases that have been run, if checks are profiled. */
+        const std::vector<TestCheckStats>& checks() const { return mChecks; }
+        
+        /** Gets the path of the test being run, i.e. the names of its parent suites and its own name separated by "/". */
+        std::string path() const { return currentPath(); }
+        
+    protected:
+        int mTestCount;             ///< The number of test executed.
+        int mFailureCount;          ///< The number of failures.
+        int mFailedTestCount;       ///< The number of test cases that failed.
+        int mCaseFailureCount;      ///< The number of failures when the current test case began.
+        int mElapsedSeconds;        ///< The total elapsed time in seconds.
+        long long mElapsedTime;     ///< The total elapsed time in nanoseconds.
+        long long mStartTime;       ///< The start time of the tests.
+        std::vector<Test*> mPath;   ///< The tests being run, from the outermost suite to the current test.
+        std::vector<const char*> mPathNames;    ///< The interned paths of the tests being run, shared by their records (see ntk::TestStrings).
+        std::vector<TestTiming> mTimings;   ///< The timings of the tests that have ended.
+        std::vector<TestBenchmarkStats> mBenchmarks;    ///< The statistics of the benchmarks that have been run.
+        std::vector<TestAllocationStats> mAllocations;  ///< The heap allocations of the test cases that have been run.
+        std::vector<TestCounterStats> mCounters;        ///< The hardware events of the test cases and benchmarks that have been run.
+        std::vector<TestCheckStats> mChecks;            ///< The checks of the assertion sites of the test cases that have been run.
+        
+    private:
+        // gets the interned path of the test being run, an empty string if there is none
+        const char* currentPath() const { return mPathNames.empty() ? "" : mPathNames.back(); }
+        
+        // interns the path of the specified test, which begins in the current test, so its records share a single copy for the whole run
+        const char* internPath(const Test* test) const {
+            TestAllocations::Pause pause;   // not part of the test
+            std::string path = mPathNames.empty() ? std::string() : (std::string(mPathNames.back()) + "/");
+            path += test->name();
+            return TestStrings::shared().intern(path.c_str());
+        }
+    };
+    
+    /** 
+     OStreamResult processes test results to an output stream. 
+     @see ntk::TestResult
+     */
+    class OStreamTestResult : public TestResult
+    {
+    public:
+        
+        /** 
+         Creates a new OStreamResult from the specified output stream.
+         If no output stream if specified, std::cout is used.
+         */
+        OStreamTestResult(std::ostream& os = std::cout)
+        : mOutStream(os), mIndent(0)
+        {}
+        
+        /** This method is called before running all tests. */
+        virtual void allTestsBegin() {
+            TestResult::allTestsBegin();
+            mOutStream << "\n\nRunning unit tests...\n\n";
+        }
+        
+        /** This method is called after all tests have been run. */
+        virtual void allTestsEnd() {
+            TestResult::allTestsEnd();
+            
+            if (!mChecks.empty())
+                printCheckProfile(10);
+            
+            mOutStream << "\nSummary:\n";
+            mOutStream << "  - Executed tests : " << std::setw(8) << std::right << mTestCount << '\n';
+            mOutStream << "  - Passed tests   : " << std::setw(8) << std::right << (mTestCount - mFailedTestCount) << '\n';
+            
+            if (failures() != 0) {
+                mOutStream << "  - Failed tests   : "  << std::setw(8) << std::right << mFailedTestCount << '\n';
+                if (failures() != failedTests())
+                    mOutStream << "  - Failures       : "  << std::setw(8) << std::right << mFailureCount << '\n';
+            }
+            
+            mOutStream << "\nTests running time: " << TestClock::format(elapsedTime()) << ".\n\n";
+            mOutStream.flush();
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            TestResult::addFailure(failure);
+            if (mPath.empty() || mPath.back()->isSuite())
+                mOutStream << std::setw(mIndent) << "! " << failure << '\n';
+            else
+                mPendingOutput << std::setw(mIndent) << "! " << failure << '\n';  // printed after the test name and duration
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            TestResult::benchmarkResult(test, stats);
+            mPendingOutput << std::setw(mIndent) << "~ " << TestClock::format(stats.median) << "/op (min " << TestClock::format(stats.min) 
+                           << ", p99 " << TestClock::format(stats.p99) << ", stddev " << TestClock::format(stats.stddev) << ", " << stats.samples 
+                           << " samples of " << stats.iterations << " iterations)" << '\n';
+        }
+        
+        /** This method is called when a test case or the samples of a benchmark have been measured, with their hardware events if they are counted. */
+        virtual void counterResult(Test* test, const TestCounterStats& stats) {
+            TestResult::counterResult(test, stats);
+            mPendingOutput << std::setw(mIndent) << "# " << stats << '\n';
+        }
+        
+        /** This method is called each time a test begins. */
+        virtual void testBegins(Test* test) {
+            TestResult::testBegins(test);
+            if (test->isSuite())
+                mOutStream << std::setw(mIndent + 2) << ((test->type() == TestType::TestSuite) ? "+ " : "- ") << test->name() << '\n';
+            mIndent += 2;
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            TestResult::testEnds(test);
+            mIndent -= 2;
+            if (!test->isSuite()) {
+                mOutStream << std::setw(mIndent + 2) << "- " << test->name() << " (" << TestClock::format(test->duration()) << ")\n";
+                mOutStream << mPendingOutput.str();
+                mPendingOutput.str("");
+            }
+        }
+        
+    protected:
+        /** 
+         Prints the profile of the checks of the specified number of test cases that took the most time checking, from the slowest, each with its 
+         slowest assertion sites.
+         */
+        void printCheckProfile(size_t count) {
+            // the assertion sites of each test case, reported together when the test case ends
+            std::map<std::string, std::vector<const TestCheckStats*> > tests;
+            for (std::vector<TestCheckStats>::const_iterator it = mChecks.begin(); it != mChecks.end(); ++it)
+                tests[it->path()].push_back(&*it);
+            std::vector<std::pair<long long, const std::string*> > durations;
+            for (std::map<std::string, std::vector<const TestCheckStats*> >::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                long long duration = 0;
+                for (std::vector<const TestCheckStats*>::const_iterator site = it->second.begin(); site != it->second.end(); ++site)
+                    duration += (*site)->duration;
+                durations.push_back(std::make_pair(-duration, &it->first));   // negated to sort from the slowest
+            }
+            count = std::min(count, durations.size());
+            std::partial_sort(durations.begin(), durations.begin() + count, durations.end());
+            mOutStream << "\nSlowest assertions:\n";
+            for (size_t i = 0; i < count; ++i) {
+                std::vector<const TestCheckStats*>& sites = tests[*durations[i].second];
+                mOutStream << "  - " << *durations[i].second << ": " << TestClock::format((double)-durations[i].first) << '\n';
+                size_t siteCount = std::min<size_t>(3, sites.size());
+                std::partial_sort(sites.begin(), sites.begin() + siteCount, sites.end(), slowerCheck);
+                for (size_t j = 0; j < siteCount; ++j)
+                    mOutStream << "      " << TestClock::format((double)sites[j]->duration) << " for " << sites[j]->count 
+                               << ((sites[j]->count == 1) ? " check at " : " checks at ") << sites[j]->file << "(" << sites[j]->line << ")\n";
+            }
+        }
+        
+        std::ostream& mOutStream;   ///< The output stream.
+        unsigned int mIndent;       ///< The current indentation.
+        std::ostringstream mPendingOutput;  ///< The failures and measures of the current test case, not yet printed.
+        
+    private:
+        // returns true if the checks of the first site took more time than the second ones
+        static bool slowerCheck(const TestCheckStats* a, const TestCheckStats* b) { return a->duration > b->duration; }
+        
+        // private copy constructor and assign operator as a stream result can't be copied
+        OStreamTestResult(const OStreamTestResult&);
+        const OStreamTestResult& operator=(const OStreamTestResult&);
+    };
+    
+    /**
+     TestStreamBuffer is a stream buffer collecting the output in a large memory block, written at once to another stream when it is full or when the 
+     buffer is flushed. It avoids flushing or writing each line to a slow output, such as a pipe.
+     */
+    class TestStreamBuffer : public std::streambuf
+    {
+    public:
+        
+        /** Creates a buffer of the specified size in bytes, writing to the specified stream. */
+        TestStreamBuffer(std::ostream& os, size_t size = 64 * 1024)
+        : mOutStream(os), mBuffer(size)
+        { setp(&mBuffer[0], &mBuffer[0] + mBuffer.size()); }
+        
+        /** Writes the buffered output and destroys the buffer. */
+        virtual ~TestStreamBuffer() { sync(); }
+        
+    protected:
+        /** Writes the buffered output when the buffer is full, then buffers the specified character. */
+        virtual int_type overflow(int_type c) {
+            if (!write())
+                return traits_type::eof();
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+        
+        /** Writes the buffered output and flushes the output stream. */
+        virtual int sync() {
+            return (write() && mOutStream.flush()) ? 0 : -1;
+        }
+        
+    private:
+        // writes the buffered output to the output stream
+        bool write() {
+            if (pptr() != pbase())
+                mOutStream.write(pbase(), pptr() - pbase());
+            setp(&mBuffer[0], &mBuffer[0] + mBuffer.size());
+            return mOutStream.good();
+        }
+        
+        std::ostream& mOutStream;   // the output stream
+        std::vector<char> mBuffer;  // the buffered output
+        
+        // private copy constructor and assign operator as a buffer can't be copied
+        TestStreamBuffer(const TestStreamBuffer&);
+        const TestStreamBuffer& operator=(const TestStreamBuffer&);
+    };
+    
+    /**
+     JUnitXmlTestResult writes the test results to an output stream in the JUnit XML format, understood by most continuous integration servers.
+     Each group of consecutive test cases of a suite is reported as a testsuite element named after the path of the suite, including the duration 
+     and failures of each test case (benchmark measures are reported as the standard output of the benchmark). The output is buffered and written a 
+     suite at a time.
+     @see ntk::TestResult
+     */
+    class JUnitXmlTestResult : public TestResult
+    {
+    public:
+        
+        /** 
+         Creates a new JUnitXmlTestResult writing to the specified output stream.
+         If no output stream if specified, std::cout is used.
+         */
+        JUnitXmlTestResult(std::ostream& os = std::cout)
+        : mBuffer(os), mOutStream(&mBuffer), mSuiteTests(0), mSuiteFailures(0), mSuiteTime(0), mTestFailures(0)
+        {
+            mOutStream << std::fixed << std::setprecision(6);
+            mSuiteOutput << std::fixed << std::setprecision(6);
+        }
+        
+        /** This method is called before running all tests. */
+        virtual void allTestsBegin() {
+            TestResult::allTestsBegin();
+            mOutStream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n";
+        }
+        
+        /** This method is called after all tests have been run. */
+        virtual void allTestsEnd() {
+            TestResult::allTestsEnd();
+            endSuite();
+            mOutStream << "</testsuites>\n";
+            mOutStream.flush();
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            if (!test->isSuite()) {
+                std::string testPath = path();
+                beginSuite(testPath.substr(0, testPath.size() - std::min(testPath.size(), std::strlen(test->name()) + 1)));
+                writeTestCase(test->name(), test->duration());
+            }
+            TestResult::testEnds(test);
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            TestResult::addFailure(failure);
+            std::string condition = failure.condition();
+            mTestOutput << "      <failure message=\"";
+            escape(mTestOutput, condition);
+            mTestOutput << "\" type=\"failure\">";
+            escape(mTestOutput, failure.fileName());
+            mTestOutput << "(" << failure.line() << "): ";
+            escape(mTestOutput, condition);
+            mTestOutput << "</failure>\n";
+            ++mTestFailures;
+            
+            if (mPath.empty() || mPath.back()->isSuite()) {
+                // failure outside of a test case, reported as a test case named after the suite
+                beginSuite(path());
+                writeTestCase(mPath.empty() ? "" : mPath.back()->name(), 0);
+            }
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            TestResult::benchmarkResult(test, stats);
+            mTestOutput << "      <system-out>" << TestClock::format(stats.median) << "/op (min " << TestClock::format(stats.min) << ", p99 " 
+                        << TestClock::format(stats.p99) << ", stddev " << TestClock::format(stats.stddev) << ", " << stats.samples << " samples of " 
+                        << stats.iterations << " iterations)</system-out>\n";
+        }
+        
+    protected:
+        /** Writes the specified text to the specified stream, escaping the XML special characters. */
+        static void escape(std::ostream& os, const std::string& text) {
+            for (std::string::const_iterator it = text.begin(); it != text.end(); ++it) {
+                switch (*it) {
+                    case '&':   os << "&amp;";  break;
+                    case '<':   os << "&lt;";   break;
+                    case '>':   os << "&gt;";   break;
+                    case '"':   os << "&quot;"; break;
+                    case '\'':  os << "&apos;"; break;
+                    default:
+                        if (((unsigned char)*it < 0x20) && (*it != '\t') && (*it != '\n') && (*it != '\r'))
+                            os << '?';  // not allowed in XML 1.0
+                        else
+                            os << *it;
+                }
+            }
+        }
+        
+        TestStreamBuffer mBuffer;           ///< The buffer of the output stream.
+        std::ostream mOutStream;            ///< The buffered output stream.
+        
+    private:
+        // begins the testsuite element of the specified suite, ending the current one if it is another suite
+        void beginSuite(const std::string& suitePath) {
+            if ((suitePath != mSuitePath) || (mSuiteTests == 0)) {
+                endSuite();
+                mSuitePath = suitePath;
+            }
+        }
+        
+        // writes the current testsuite element, if any
+        void endSuite() {
+            if (mSuiteTests == 0)
+                return;
+            mOutStream << "  <testsuite name=\"";
+            escape(mOutStream, mSuitePath);
+            mOutStream << "\" tests=\"" << mSuiteTests << "\" failures=\"" << mSuiteFailures << "\" errors=\"0\" time=\"" << (mSuiteTime / 1e9) << "\">\n"
+                       << mSuiteOutput.str() << "  </testsuite>\n";
+            mSuiteOutput.str("");
+            mSuiteTests = 0;
+            mSuiteFailures = 0;
+            mSuiteTime = 0;
+        }
+        
+        // writes a testcase element with the failures and output of the test
+        void writeTestCase(const std::string& name, long long duration) {
+            std::string className = mSuitePath;
+            std::replace(className.begin(), className.end(), '/', '.');
+            mSuiteOutput << "    <testcase name=\"";
+            escape(mSuiteOutput, name);
+            mSuiteOutput << "\" classname=\"";
+            escape(mSuiteOutput, className);
+            mSuiteOutput << "\" time=\"" << (duration / 1e9) << "\"";
+            if (mTestOutput.tellp() > 0)
+                mSuiteOutput << ">\n" << mTestOutput.str() << "    </testcase>\n";
+            else
+                mSuiteOutput << "/>\n";
+            
+            ++mSuiteTests;
+            mSuiteFailures += (mTestFailures != 0) ? 1 : 0;
+            mSuiteTime += duration;
+            mTestOutput.str("");
+            mTestFailures = 0;
+        }
+        
+        std::string mSuitePath;             // the path of the current suite
+        std::ostringstream mSuiteOutput;    // the test cases of the current suite
+        int mSuiteTests;                    // the number of test cases of the current suite
+        int mSuiteFailures;                 // the number of failed test cases of the current suite
+        long long mSuiteTime;               // the duration of the test cases of the current suite
+        std::ostringstream mTestOutput;     // the failures and output of the current test case
+        int mTestFailures;                  // the number of failures of the current test case
+        
+        // private copy constructor and assign operator as a stream result can't be copied
+        JUnitXmlTestResult(const JUnitXmlTestResult&);
+        const JUnitXmlTestResult& operator=(const JUnitXmlTestResult&);
+    };
+    
+    /**
+     JsonLinesTestResult writes the test results to an output stream as JSON lines, i.e. one JSON object per line, easy to process by log collectors.
+     A "test" object is written when each test case ends, with its path, type, duration in nanoseconds, status, failures, benchmark measures and 
+     profiled checks, then a "summary" object after all tests. Failures occuring outside of a test case are written as "failure" objects. The output is buffered.
+     @see ntk::TestResult
+     */
+    class JsonLinesTestResult : public TestResult
+    {
+    public:
+        
+        /** 
+         Creates a new JsonLinesTestResult writing to the specified output stream.
+         If no output stream if specified, std::cout is used.
+         */
+        JsonLinesTestResult(std::ostream& os = std::cout)
+        : mBuffer(os), mOutStream(&mBuffer)
+        {
+            mOutStream << std::setprecision(12);
+        }
+        
+        /** This method is called after all tests have been run. */
+        virtual void allTestsEnd() {
+            TestResult::allTestsEnd();
+            mOutStream << "{\"type\":\"summary\",\"tests\":" << mTestCount << ",\"failed_tests\":" << mFailedTestCount << ",\"failures\":" 
+                       << mFailureCount << ",\"duration_ns\":" 
+                       << elapsedTime() << "}\n";
+            mOutStream.flush();
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            if (!test->isSuite()) {
+                mOutStream << "{\"type\":\"test\",\"path\":";
+                quote(mOutStream, path());
+                mOutStream << ",\"kind\":";
+                quote(mOutStream, test->type().name());
+                mOutStream << ",\"duration_ns\":" << test->duration() << ",\"status\":\"" << (mFailures.empty() ? "passed" : "failed") << "\"";
+                if (!mFailures.empty()) {
+                    mOutStream << ",\"failures\":[";
+                    for (std::vector<TestFailure>::const_iterator it = mFailures.begin(); it != mFailures.end(); ++it) {
+                        mOutStream << ((it != mFailures.begin()) ? "," : "");
+                        writeFailure(*it);
+                    }
+                    mOutStream << "]";
+                }
+                if (!mStats.empty()) {
+                    const TestBenchmarkStats& stats = mStats.back();
+                    mOutStream << ",\"benchmark\":{\"iterations\":" << stats.iterations << ",\"samples\":" << stats.samples << ",\"min_ns\":" 
+                               << stats.min << ",\"median_ns\":" << stats.median << ",\"p99_ns\":" << stats.p99 << ",\"mean_ns\":" << stats.mean 
+                               << ",\"stddev_ns\":" << stats.stddev << "}";
+                }
+                if (!mAllocationStats.empty()) {
+                    const TestAllocationStats& stats = mAllocationStats.back();
+                    mOutStream << ",\"allocations\":{\"count\":" << stats.allocations << ",\"deallocations\":" << stats.deallocations << ",\"bytes\":" 
+                               << stats.bytes << ",\"peak_bytes\":" << stats.peakBytes << ",\"retained_bytes\":" << stats.retainedBytes << "}";
+                }
+                if (!mCounterStats.empty())
+                    writeCounters(mCounterStats.back());
+                if (!mCheckStats.empty()) {
+                    mOutStream << ",\"checks\":[";
+                    for (std::vector<TestCheckStats>::const_iterator it = mCheckStats.begin(); it != mCheckStats.end(); ++it) {
+                        mOutStream << ((it != mCheckStats.begin()) ? "," : "") << "{\"file\":";
+                        quote(mOutStream, it->file);
+                        mOutStream << ",\"line\":" << it->line << ",\"count\":" << it->count << ",\"duration_ns\":" << it->duration << "}";
+                    }
+                    mOutStream << "]";
+                }
+                mOutStream << "}\n";
+                mFailures.clear();
+                mStats.clear();
+                mAllocationStats.clear();
+                mCounterStats.clear();
+                mCheckStats.clear();
+            }
+            TestResult::testEnds(test);
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            TestResult::addFailure(failure);
+            if (!mPath.empty() && !mPath.back()->isSuite()) {
+                mFailures.push_back(failure);   // written with the test case
+                return;
+            }
+            mOutStream << "{\"type\":\"failure\",\"path\":";
+            quote(mOutStream, path());
+            mOutStream << ",";
+            writeFailureFields(failure);
+            mOutStream << "}\n";
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            TestResult::benchmarkResult(test, stats);
+            mStats.push_back(stats);
+        }
+        
+        /** This method is called when a test case ends, with its heap allocations if they are tracked. */
+        virtual void allocationResult(Test* test, const TestAllocationStats& stats) {
+            TestResult::allocationResult(test, stats);
+            mAllocationStats.push_back(stats);
+        }
+        
+        /** This method is called when a test case or the samples of a benchmark have been measured, with their hardware events if they are counted. */
+        virtual void counterResult(Test* test, const TestCounterStats& stats) {
+            TestResult::counterResult(test, stats);
+            mCounterStats.push_back(stats);
+        }
+        
+        /** This method is called when a test case ends, once per assertion site it checked if checks are profiled. */
+        virtual void checkResult(Test* test, const TestCheckStats& stats) {
+            TestResult::checkResult(test, stats);
+            mCheckStats.push_back(stats);
+        }
+        
+    protected:
+        /** Writes the specified text to the specified stream as a JSON string. */
+        static void quote(std::ostream& os, const std::string& text) {
+            static const char digits[] = "0123456789abcdef";
+            os << '"';
+            for (std::string::const_iterator it = text.begin(); it != text.end(); ++it) {
+                switch (*it) {
+                    case '"':   os << "\\\"";   break;
+                    case '\\':  os << "\\\\";   break;
+                    case '\n':  os << "\\n";    break;
+                    case '\r':  os << "\\r";    break;
+                    case '\t':  os << "\\t";    break;
+                    default:
+                        if ((unsigned char)*it < 0x20)
+                            os << "\\u00" << digits[(unsigned char)*it >> 4] << digits[*it & 0xf];
+                        else
+                            os << *it;
+                }
+            }
+            os << '"';
+        }
+        
+        TestStreamBuffer mBuffer;           ///< The buffer of the output stream.
+        std::ostream mOutStream;            ///< The buffered output stream.
+        
+    private:
+        // writes a failure object
+        void writeFailure(const TestFailure& failure) {
+            mOutStream << "{";
+            writeFailureFields(failure);
+            mOutStream << "}";
+        }
+        
+        // writes the fields of a failure object
+        void writeFailureFields(const TestFailure& failure) {
+            mOutStream << "\"file\":";
+            quote(mOutStream, failure.fileName());
+            mOutStream << ",\"line\":" << failure.line() << ",\"condition\":";
+            quote(mOutStream, failure.condition());
+        }
+        
+        // writes the counters object of the hardware events of a test case, the unknown events being null
+        void writeCounters(const TestCounterStats& stats) {
+            const char* names[] = { "cycles", "instructions", "cache_references", "cache_misses", "branches", "branch_misses", "ipc", 
+                                    "cache_miss_rate", "branch_miss_rate" };
+            double values[] = { stats.cycles, stats.instructions, stats.cacheReferences, stats.cacheMisses, stats.branches, stats.branchMisses, 
+                                stats.ipc(), stats.cacheMissRate(), stats.branchMissRate() };
+            mOutStream << ",\"counters\":{\"operations\":" << stats.operations;
+            for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+                mOutStream << ",\"" << names[i] << "\":";
+                if (values[i] < 0)
+                    mOutStream << "null";
+                else
+                    mOutStream << values[i];
+            }
+            mOutStream << "}";
+        }
+        
+        std::vector<TestFailure> mFailures;         // the failures of the current test case
+        std::vector<TestBenchmarkStats> mStats;     // the benchmark measures of the current test case
+        std::vector<TestAllocationStats> mAllocationStats;  // the heap allocations of the current test case
+        std::vector<TestCounterStats> mCounterStats;        // the hardware events of the current test case
+        std::vector<TestCheckStats> mCheckStats;            // the checks of the assertion sites of the current test case
+        
+        // private copy constructor and assign operator as a stream result can't be copied
+        JsonLinesTestResult(const JsonLinesTestResult&);
+        const JsonLinesTestResult& operator=(const JsonLinesTestResult&);
+    };
+    
+    /**
+     TestRecorder stores the test results so they can be processed later by another TestResult object, in the same order as they occured.
+     It is used to run tests on worker threads while committing their results from the main thread only.
+     @see ntk::TestResult
+     */
+    class TestRecorder : public TestResult
+    {
+    public:
+        
+        /** This method is called each time a test begins. */
+        virtual void testBegins(Test* test) {
+            mEvents.push_back(Event(Event::Begin, test));   // not counted, the test is counted when replayed
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            mEvents.push_back(Event(Event::End, test));
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            TestResult::addFailure(failure);
+            mEvents.push_back(Event(Event::Failure, NULL, mFailures.size()));
+            mFailures.push_back(failure);
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            mEvents.push_back(Event(Event::Benchmark, test, mBenchmarkStats.size()));
+            mBenchmarkStats.push_back(stats);
+        }
+        
+        /** This method is called when a test case ends, with its heap allocations if they are tracked. */
+        virtual void allocationResult(Test* test, const TestAllocationStats& stats) {
+            mEvents.push_back(Event(Event::Allocations, test, mAllocationStats.size()));
+            mAllocationStats.push_back(stats);
+        }
+        
+        /** This method is called when a test case or the samples of a benchmark have been measured, with their hardware events if they are counted. */
+        virtual void counterResult(Test* test, const TestCounterStats& stats) {
+            mEvents.push_back(Event(Event::Counters, test, mCounterStats.size()));
+            mCounterStats.push_back(stats);
+        }
+        
+        /** This method is called when a test case ends, once per assertion site it checked if checks are profiled. */
+        virtual void checkResult(Test* test, const TestCheckStats& stats) {
+            mEvents.push_back(Event(Event::Checks, test, mCheckStats.size()));
+            mCheckStats.push_back(stats);
+        }
+        
+        /** Processes all the recorded results using the specified TestResult object. */
+        void replay(TestResult& result) const {
+            for (std::vector<Event>::const_iterator it = mEvents.begin(); it != mEvents.end(); ++it) {
+                switch (it->type) {
+                    case Event::Begin:      result.testBegins(it->test);                break;
+                    case Event::End:        result.testEnds(it->test);                  break;
+                    case Event::Failure:    result.addFailure(mFailures[it->index]);    break;
+                    case Event::Benchmark:  result.benchmarkResult(it->test, mBenchmarkStats[it->index]);   break;
+                    case Event::Allocations: result.allocationResult(it->test, mAllocationStats[it->index]); break;
+                    case Event::Counters:   result.counterResult(it->test, mCounterStats[it->index]);   break;
+                    case Event::Checks:     result.checkResult(it->test, mCheckStats[it->index]);       break;
+                }
+            }
+        }
+        
+    private:
+        // a recorded result event
+        struct Event {
+            enum Type { Begin, End, Failure, Benchmark, Allocations, Counters, Checks };
+            Event(Type theType, Test* theTest, size_t theIndex = 0) : type(theType), test(theTest), index(theIndex) {}
+            Type type;
+            Test* test;
+            size_t index;
+        };
+        
+        std::vector<Event> mEvents;         // the recorded events
+        std::vector<TestFailure> mFailures; // the recorded failures
+        std::vector<TestBenchmarkStats> mBenchmarkStats;    // the recorded benchmark measures
+        std::vector<TestAllocationStats> mAllocationStats;  // the recorded heap allocations
+        std::vector<TestCounterStats> mCounterStats;        // the recorded hardware events
+        std::vector<TestCheckStats> mCheckStats;            // the recorded checks of the assertion sites
+    };
+    
+#pragma mark -
+#pragma mark Parameterized tests
+    
+    /** A TestData object references a record of a test data file, the parameter of the cases declared with TEST_DATA. */
+    struct TestData {
+        
+        /** Creates a reference to the specified bytes. */
+        TestData(const char* theData = NULL, size_t theSize = 0) : data(theData), size(theSize) {}
+        
+        /** Gets a copy of the record. */
+        std::string str() const { return std::string(data, size); }
+        
+        const char* data;   ///< The bytes of the record, not followed by the record separator nor by a null character.
+        size_t size;        ///< The number of bytes of the record.
+    };
+    
+    /** Writes the bytes of the specified record to the specified stream. */
+    inline std::ostream& operator<<(std::ostream& os, const TestData& data) {
+        return os.write(data.data, data.size);
+    }
+    
+    /** 
+     A TestRange generates the values from first (included) to last (excluded) separated by a step, without storing them.
+     It can be given to TEST_P as any other random access container, such as a std::vector.
+     */
+    template <typename T>
+    class TestRange {
+    public:
+        
+        /** Creates a range of the values from first to last (excluded), separated by the specified positive step. */
+        TestRange(T first, T last, T step = 1)
+        : mFirst(first), mStep(step), mSize((last > first) ? (size_t)std::ceil((double)(last - first) / step) : 0)
+        {}
+        
+        /** Gets the number of values. */
+        size_t size() const { return mSize; }
+        
+        /** Gets the value with the specified index. */
+        T operator[](size_t index) const { return (T)(mFirst + (T)index * mStep); }
+        
+    private:
+        T mFirst;       // the first value
+        T mStep;        // the difference between two values
+        size_t mSize;   // the number of values
+    };
+    
+    /**
+     TestValues provides the cases of a test declared with TEST_P from a random access container (anything with size() and operator[], such as a 
+     std::vector or a ntk::TestRange), with one case per value named after its index. The cases are run in batches of 256 cases by default.
+     @see ntk::TestParameterized
+     */
+    template <typename Generator>
+    class TestValues {
+    public:
+        
+        /** The parameter of the cases, i.e. the type of the values. */
+        typedef typename std::decay<decltype(std::declval<const Generator&>()[0])>::type Parameter;
+        
+        /** Reads the cases of a batch, in order. */
+        class Reader {
+        public:
+            /** Creates a reader of the specified batch of the specified values. */
+            Reader(const TestValues& values, size_t batch) 
+            : mGenerator(values.mGenerator), mIndex(batch * values.mBatchSize), 
+              mEnd(std::min(values.mGenerator.size(), (batch + 1) * values.mBatchSize)), mStarted(false) 
+            {}
+            
+            /** Moves to the next case of the batch, returns false if there is none left. */
+            bool next() {
+                mIndex += mStarted ? 1 : 0;
+                mStarted = true;
+                return (mIndex < mEnd);
+            }
+            
+            /** Gets the name of the current case, i.e. its index. */
+            std::string name() const {
+                std::ostringstream ss;
+                ss << mIndex;
+                return ss.str();
+            }
+            
+            /** Gets the parameter of the current case. */
+            Parameter parameter() const { return mGenerator[mIndex]; }
+            
+        private:
+            const Generator& mGenerator;    // the values
+            size_t mIndex;                  // the index of the current case
+            size_t mEnd;                    // the index following the last case of the batch
+            bool mStarted;                  // true once the first case has been read
+        };
+        
+        /** Creates the cases of the specified values (copied), run in batches of the specified number of cases. */
+        TestValues(const Generator& generator, size_t batchSize = 256) : mGenerator(generator), mBatchSize(std::max((size_t)1, batchSize)) {}
+        
+        /** Gets the number of batches. */
+        size_t batchCount() const { return (mGenerator.size() + mBatchSize - 1) / mBatchSize; }
+        
+        /** Gets the name of the specified batch, made of the names of its first and last cases. */
+        std::string batchName(size_t batch) const {
+            std::ostringstream ss;
+            ss << "[" << (batch * mBatchSize) << "-" << (std::min(mGenerator.size(), (batch + 1) * mBatchSize) - 1) << "]";
+            return ss.str();
+        }
+        
+        /** Gets the reason why the cases can't be read, empty as values can always be read. */
+        std::string error() const { return ""; }
+        
+    private:
+        Generator mGenerator;   // the values
+        size_t mBatchSize;      // the number of cases per batch
+    };
+    
+    /**
+     TestDataFile provides the cases of a test declared with TEST_DATA from the records of a file, separated by a separator character (a new line by
+     default). Each case is named after the offset of its record in the file.
+     
+     The file is never loaded whole: it is split in batches of 1 MB by default, each batch running the cases of the records beginning in its range. A 
+     batch streams its range from the file in chunks of 64 KB, keeping only the bytes from its current record on and reading past its range as needed
+     to complete its last record, so several batches can be run in parallel with a bounded memory use whatever the size of the file.
+     @see ntk::TestParameterized
+     */
+    class TestDataFile {
+    public:
+        
+        /** The parameter of the cases, a reference to a record valid while the case is run. */
+        typedef TestData Parameter;
+        
+        /** Reads the records of a batch, in order. */
+        class Reader {
+        public:
+            /** Creates a reader of the specified batch of the specified file. */
+            Reader(const TestDataFile& file, size_t batch)
+            : mStream(file.mFileName.c_str(), std::ios::binary), mSeparator(file.mSeparator), mOffset(0), mLimit(0), mNext(0), mBegin(0), mEnd(0)
+            {
+                long long begin = (long long)batch * file.mBatchSize;
+                mLimit = std::min(file.mSize, begin + file.mBatchSize);
+                mOffset = (begin > 0) ? (begin - 1) : 0;   // the byte before the batch, to know whether a record begins with it
+                mStream.seekg(mOffset);
+                if (begin > 0) {
+                    // skip the end of the record begun in a previous batch, without reading past the range of the batch
+                    size_t length = 0;
+                    bool found = findSeparator(length, mLimit);
+                    mNext = mBegin + length + (found ? 1 : 0);
+                }
+            }
+            
+            /** Moves to the next record of the batch, returns false if there is none left. */
+            bool next() {
+                mBegin = mNext;
+                if (mOffset + (long long)mBegin >= mLimit)
+                    return false;
+                size_t length = 0;
+                bool found = findSeparator(length, std::numeric_limits<long long>::max());   // the last record is completed past the range
+                if (!found && (length == 0))
+                    return false;   // the file is shorter than expected
+                mEnd = mBegin + length;
+                mNext = mEnd + 1;
+                return true;
+            }
+            
+            /** Gets the name of the current case, i.e. the offset of its record in the file. */
+            std::string name() const {
+                std::ostringstream ss;
+                ss << (mOffset + (long long)mBegin);
+                return ss.str();
+            }
+            
+            /** Gets the parameter of the current case, a reference to its record valid until the next record is read. */
+            Parameter parameter() const { return TestData(mData.data() + mBegin, mEnd - mBegin); }
+            
+        private:
+            enum { ChunkSize = 64 * 1024 };
+            
+            // gets the length of the bytes from the current record to the next separator, reading the file up to the specified offset, returns
+            // false if there is no separator before the offset or the end of the file
+            bool findSeparator(size_t& length, long long limit) {
+                length = 0;
+                for (;;) {
+                    size_t searched = mBegin + length;
+                    const char* separator = (searched < mData.size()) ?
+                        static_cast<const char*>(std::memchr(mData.data() + searched, mSeparator, mData.size() - searched)) : NULL;
+                    if (separator != NULL) {
+                        length = (size_t)(separator - mData.data()) - mBegin;
+                        return true;
+                    }
+                    length = mData.size() - mBegin;
+                    if ((mOffset + (long long)mData.size() >= limit) || !readMore())
+                        return false;
+                }
+            }
+            
+            // drops the bytes preceding the current record and reads the next chunk of the file, returns false at the end of the file
+            bool readMore() {
+                if (mBegin > 0) {
+                    mData.erase(mData.begin(), mData.begin() + mBegin);
+                    mOffset += mBegin;
+                    mNext -= std::min(mNext, mBegin);
+                    mBegin = 0;
+                }
+                size_t size = mData.size();
+                mData.resize(size + ChunkSize);
+                mStream.read(&mData[size], ChunkSize);
+                mData.resize(size + (size_t)mStream.gcount());
+                return (mData.size() > size);
+            }
+            
+            std::ifstream mStream;      // the file
+            char mSeparator;            // the record separator
+            long long mOffset;          // the offset in the file of the first byte read and kept
+            std::vector<char> mData;    // the bytes read from the file and kept, from the current record on
+            long long mLimit;           // the offset in the file following the range of the batch
+            size_t mNext;               // the position in the bytes read of the next record
+            size_t mBegin;              // the position in the bytes read of the current record
+            size_t mEnd;                // the position in the bytes read following the current record
+        };
+        
+        /** Creates the cases of the records of the specified file separated by the specified character, run in batches of the specified size in bytes. */
+        TestDataFile(const std::string& fileName, char separator = '\n', long long batchSize = 1 << 20)
+        : mFileName(fileName), mSeparator(separator), mBatchSize(std::max(1ll, batchSize)), mSize(-1)
+        {
+            std::ifstream file(fileName.c_str(), std::ios::binary | std::ios::ate);
+            if (file)
+                mSize = (long long)file.tellg();
+        }
+        
+        /** Gets the number of batches, a file that can't be read having a single batch reporting the error. */
+        size_t batchCount() const { return (mSize < 0) ? 1 : (size_t)((mSize + mBatchSize - 1) / mBatchSize); }
+        
+        /** Gets the name of the specified batch, made of the offsets of its first and last bytes. */
+        std::string batchName(size_t batch) const {
+            if (mSize < 0)
+                return "[" + mFileName + "]";
+            std::ostringstream ss;
+            ss << "[" << ((long long)batch * mBatchSize) << "-" << (std::min(mSize, (long long)(batch + 1) * mBatchSize) - 1) << "]";
+            return ss.str();
+        }
+        
+        /** Gets the reason why the cases can't be read, or an empty string if the file can be read. */
+        std::string error() const { return (mSize < 0) ? ("Unable to read the test data file " + mFileName) : ""; }
+        
+    private:
+        std::string mFileName;  // the file
+        char mSeparator;        // the record separator
+        long long mBatchSize;   // the number of bytes per batch
+        long long mSize;        // the size of the file in bytes, negative if it can't be read
+    };
+    
+    /** 
+     A TestParameterCase is a case of a parameterized test, running the test code with one parameter. The cases are created while the test is run.
+     @see TEST_P
+     */
+    template <typename P>
+    class TestParameterCase : public Test {
+    public:
+        
+        /** The type of the parameter. */
+        typedef P Parameter;
+        
+        /** Creates a case with the specified name and parameter. */
+        TestParameterCase(const std::string& name, const Parameter& parameter) : Test(name), param(parameter) {}
+        
+        const Parameter param;  ///< The parameter of the case.
+    };
+    
+    /**
+     A TestBatch runs a range of the cases of a parameterized test, and is the unit of test selection, sharding, durations and scheduling for them.
+     A batch is not reported itself: each of its cases is reported as a test case of the parameterized test. The cases are kept until released by
+     the parameterized test, once their results have been committed.
+     @see ntk::TestParameterized
+     */
+    class TestBatch : public Test {
+    public:
+        
+        /** Creates a batch with the specified name. */
+        TestBatch(const std::string& name) : Test(name, TestType::TestBatch) {}
+        
+        /** Destroys the batch and its cases. */
+        virtual ~TestBatch() { releaseCases(); }
+        
+        /** Runs the cases of the batch, using the specified TestResult object to process the results of each case. */
+        virtual int run(TestResult& result) {
+            int failuresBeforeTest = result.failures();
+            long long startTime = TestClock::now();
+            runCases(result);
+            mDuration = TestClock::now() - startTime;
+            return (result.failures() - failuresBeforeTest);
+        }
+        
+        /** Creates a case with the specified name that is only reported, for the cases run in a child process. */
+        Test& addCase(const std::string& name) { return keep(new ReportedCase(name)); }
+        
+        /** Destroys the cases of the batch. */
+        void releaseCases() {
+            for (std::vector<Test*>::iterator it = mCases.begin(); it != mCases.end(); ++it)
+                delete *it;
+            mCases.clear();
+        }
+        
+    protected:
+        /** The method creating the cases with keep() and running them, to be overriden. */
+        virtual void runCases(TestResult& result) = 0;
+        
+        /** Does nothing, runCases() is used instead. */
+        virtual void runTest(TestResult& result) {}
+        
+        /** Keeps the specified case, created with new, as a test of the parameterized test. */
+        Test& keep(Test* test) {
+            test->mParent = parent();
+            mCases.push_back(test);
+            return *test;
+        }
+        
+    private:
+        // a case that is only reported
+        class ReportedCase : public Test {
+        public:
+            ReportedCase(const std::string& name) : Test(name) {}
+        protected:
+            virtual void runTest(TestResult& result) {}
+        };
+        
+        std::vector<Test*> mCases;  // the cases created by the last run
+    };
+    
+    /**
+     A TestParameterized test runs the same test code with each parameter given by a source, as a suite of cases reported like any other test case.
+     The cases are run in batches, which are the tests of the suite: batches can be run in parallel, and are listed, selected and sharded like test 
+     cases, so a case is selected with the path of its batch. The cases of a batch are created when it is run.
+     
+     A source provides a Parameter type and a Reader class reading the cases of a batch in order, see ntk::TestValues and ntk::TestDataFile.
+     The TEST_P and TEST_DATA macros are meant to simplify the declaration of parameterized tests.
+     @see TEST_P
+     @see TEST_DATA
+     */
+    template <typename Case, typename Source>
+    class TestParameterized : public TestSuite {
+    public:
+        
+        /** 
+         Creates a parameterized test with the specified name, running the cases of the specified source. 
+         The file and line of the declaration of the test (with a static lifetime) locate the failure reported if the source can't be read.
+         */
+        TestParameterized(const std::string& name, const Source& source, const char* file = "unknown file", int line = -1) 
+        : TestSuite(name, TestType::TestSuite, false), mSource(source), mFile(file), mLine(line) 
+        {
+            addBatches();
+        }
+        
+        /** Creates a parameterized test with the specified name (with a static lifetime, it is not copied), running the cases of the specified source. */
+        TestParameterized(StaticName name, const Source& source, const char* file = "unknown file", int line = -1) 
+        : TestSuite(name, TestType::TestSuite, false), mSource(source), mFile(file), mLine(line) 
+        {
+            addBatches();
+        }
+        
+        /** Destroys the test and its batches. */
+        virtual ~TestParameterized() {
+            for (std::vector<Test*>::iterator it = mTests.begin(); it != mTests.end(); ++it)
+                delete *it;
+        }
+        
+    protected:
+        /** Runs the batches, releasing the cases of each batch once committed. */
+        virtual void runTest(TestResult& result) {
+            for (std::vector<Test*>::iterator it = mTests.begin(); it != mTests.end(); ++it) {
+                dispatch(*it, result);
+                result.drain();
+                static_cast<TestBatch*>(*it)->releaseCases();
+            }
+            mFixtures.release();
+        }
+        
+    private:
+        // adds the batches of the cases of the source
+        void addBatches() {
+            for (size_t i = 0; i < mSource.batchCount(); ++i)
+                addTest(new Batch(*this, i));
+        }
+        
+        // a batch of the cases of the source
+        class Batch : public TestBatch {
+        public:
+            Batch(TestParameterized& test, size_t index) : TestBatch(test.mSource.batchName(index)), mTest(test), mIndex(index) {}
+            
+        protected:
+            virtual void runCases(TestResult& result) {
+                std::string error = mTest.mSource.error();
+                if (!error.empty()) {
+                    Test& test = addCase(name());     // reported as a failed case of the test
+                    result.testBegins(&test);
+                    result.addFailure(TestFailure(error, test.name(), mTest.mFile, mTest.mLine));
+                    result.testEnds(&test);
+                    return;
+                }
+                typename Source::Reader reader(mTest.mSource, mIndex);
+                while (reader.next())
+                    keep(new Case(reader.name(), reader.parameter())).run(result);
+            }
+            
+        private:
+            TestParameterized& mTest;   // the parameterized test
+            size_t mIndex;              // the index of the batch in the source
+        };
+        
+        Source mSource;     // the source of the cases
+        const char* mFile;  // the file declaring the test
+        int mLine;          // the line declaring the test
+    };
+    
+#ifndef DO_NOT_USE_THREADS
+    
+#pragma mark -
+#pragma mark Parallel test execution
+    
+    /**
+     TestWorkerPool runs test cases ahead of time on a pool of worker threads.
+     All eligible test cases are scheduled at once when the pool is created, then picked by workers from a shared queue. Their results are recorded
+     and committed once the main thread reaches the test while walking the test tree, so results are always processed in declaration order.
+     If recorded durations are available, the longest tests are run first so that a long test started last does not delay the end of the run.
+     Serial test cases (such as benchmarks) and test cases that are part of a serial test suite are not scheduled, and are run on the main thread once
+     all scheduled tests are done.
+     @see Test::runAll()
+     */
+    class TestWorkerPool {
+    public:
+        
+        /** 
+         Creates a pool of worker threads running the specified tests, using the number of jobs specified in the options.
+         The tests prioritized by the filter of the run are run first, then the specified recorded durations are used to run the longest tests first.
+         */
+        TestWorkerPool(const std::vector<Test*>& tests, const TestOptions& options, const TestDurations& durations = TestDurations())
+        : mPending(0), mStopping(false)
+        {
+#ifdef __T_USE_PROCESSES
+            if (options.isolation != TestOptions::NoIsolation)
+                return;     // tests are dispatched on child processes instead
+#endif
+            unsigned int jobs = options.jobs;
+            if (jobs == 0)
+                jobs = std::max(1u, std::thread::hardware_concurrency());
+            if (jobs <= 1)
+                return;
+            
+            schedule(tests, "", false, durations);
+            std::stable_sort(mQueue.begin(), mQueue.end(), Job::runsBefore);
+            for (unsigned int i = 0; i < jobs; ++i)
+                mWorkers.push_back(std::thread(&TestWorkerPool::work, this));
+            active() = this;
+        }
+        
+        /** Waits for all scheduled tests to complete and destroys the pool. */
+        ~TestWorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+            mWorkAvailable.notify_all();
+            for (std::vector<std::thread>::iterator it = mWorkers.begin(); it != mWorkers.end(); ++it)
+                it->join();
+            for (std::map<Test*, Job*>::iterator it = mJobs.begin(); it != mJobs.end(); ++it)
+                delete it->second;
+            if (active() == this)
+                active() = NULL;
+        }
+        
+        /** 
+         Commits the results of the specified test if it was scheduled, waiting for it to complete if needed. 
+         Returns false if the test was not scheduled in this pool.
+         */
+        bool replay(Test* test, TestResult& result) {
+            std::map<Test*, Job*>::iterator it = mJobs.find(test);
+            if (it == mJobs.end())
+                return false;
+            
+            Job* job = it->second;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                while (!job->done)
+                    mJobDone.wait(lock);
+            }
+            job->recorder.replay(result);
+            mJobs.erase(it);
+            delete job;
+            return true;
+        }
+        
+        /** Waits until all the scheduled tests have been run. */
+        void waitIdle() {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (mPending != 0)
+                mJobDone.wait(lock);
+        }
+        
+        /** Cancels the scheduled tests that have not been started yet, they will not be replayed. */
+        void cancel() {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPending -= mQueue.size();
+            mQueue.clear();
+        }
+        
+        /** Gets the pool used by the current run, or NULL if tests are run serially. */
+        static TestWorkerPool*& active() { static TestWorkerPool* pool = NULL; return pool; }
+        
+    private:
+        // a scheduled test with its recorded results
+        struct Job {
+            Job(Test* theTest, long long theDuration) : test(theTest), prioritized(TestFilter::prioritizes(theTest)), duration(theDuration), done(false) {}
+            static bool runsBefore(const Job* job, const Job* other) {
+                return (job->prioritized != other->prioritized) ? job->prioritized : (job->duration > other->duration);
+            }
+            Test* test;
+            bool prioritized;       // true if the test is run first
+            long long duration;     // the expected duration
+            TestRecorder recorder;
+            bool done;
+        };
+        
+        // schedules all test cases that are not serial nor part of a serial suite
+        void schedule(const std::vector<Test*>& tests, const std::string& parentPath, bool serial, const TestDurations& durations) {
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+                if (!TestFilter::accepts(*it)) {
+                    continue;
+                } else if ((*it)->isSuite()) {
+                    TestSuite* suite = static_cast<TestSuite*>(*it);
+                    schedule(suite->tests(), path, serial || suite->isSerial(), durations);
+                } else if (!serial && !(*it)->isSerial() && (mJobs.find(*it) == mJobs.end())) {
+                    Job* job = new Job(*it, durations.empty() ? 0 : durations.estimate(path));
+                    mJobs[*it] = job;
+                    mQueue.push_back(job);
+                    ++mPending;
+                }
+            }
+        }
+        
+        // worker thread loop
+        void work() {
+            std::unique_lock<std::mutex> lock(mMutex);
+            for (;;) {
+                while (mQueue.empty() && !mStopping)
+                    mWorkAvailable.wait(lock);
+                if (mQueue.empty())
+                    return;
+                
+                Job* job = mQueue.front();
+                mQueue.pop_front();
+                lock.unlock();
+                job->test->run(job->recorder);
+                lock.lock();
+                job->done = true;
+                --mPending;
+                mJobDone.notify_all();
+            }
+        }
+        
+        std::map<Test*, Job*> mJobs;            // the scheduled jobs not yet replayed, only accessed from the main thread
+        std::deque<Job*> mQueue;                // the jobs waiting for a worker
+        std::vector<std::thread> mWorkers;      // the worker threads
+        size_t mPending;                        // the number of jobs not yet completed
+        bool mStopping;                         // true when the pool is being destroyed
+        std::mutex mMutex;                      // protects the queue and the jobs state
+        std::condition_variable mWorkAvailable; // signaled when jobs are available or the pool is stopping
+        std::condition_variable mJobDone;       // signaled when a job has been completed
+        
+        // private copy constructor and assign operator as a pool can't be copied
+        TestWorkerPool(const TestWorkerPool&);
+        const TestWorkerPool& operator=(const TestWorkerPool&);
+    };
+    
+#pragma mark -
+#pragma mark Test timeouts
+    
+    /**
+     SynchronizedTestResult forwards the test results to another TestResult object while holding a lock, so results can be safely committed from 
+     several threads.
+     @see ntk::TestWatchdog
+     */
+    class SynchronizedTestResult : public TestResult
+    {
+    public:
+        
+        /** Creates a new synchronized result forwarding the results to the specified TestResult object. */
+        SynchronizedTestResult(TestResult& result) : mResult(result) {}
+        
+        /** This method is called before running all tests. */
+        virtual void allTestsBegin() {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::allTestsBegin();
+            mResult.allTestsBegin();
+        }
+        
+        /** This method is called after all tests have been run. */
+        virtual void allTestsEnd() {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::allTestsEnd();
+            mResult.allTestsEnd();
+        }
+        
+        /** This method is called each time a test begins. */
+        virtual void testBegins(Test* test) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::testBegins(test);
+            mResult.testBegins(test);
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::testEnds(test);
+            mResult.testEnds(test);
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::addFailure(failure);
+            mResult.addFailure(failure);
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::benchmarkResult(test, stats);
+            mResult.benchmarkResult(test, stats);
+        }
+        
+        /** This method is called when a test case ends, with its heap allocations if they are tracked. */
+        virtual void allocationResult(Test* test, const TestAllocationStats& stats) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::allocationResult(test, stats);
+            mResult.allocationResult(test, stats);
+        }
+        
+        /** This method is called when a test case or the samples of a benchmark have been measured, with their hardware events if they are counted. */
+        virtual void counterResult(Test* test, const TestCounterStats& stats) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::counterResult(test, stats);
+            mResult.counterResult(test, stats);
+        }
+        
+        /** This method is called when a test case ends, once per assertion site it checked if checks are profiled. */
+        virtual void checkResult(Test* test, const TestCheckStats& stats) {
+            std::lock_guard<std::recursive_timed_mutex> lock(mMutex);
+            TestResult::checkResult(test, stats);
+            mResult.checkResult(test, stats);
+        }
+        
+        /** Waits until the forwarded results have been processed, without holding the lock. */
+        virtual void drain() {
+            mResult.drain();
+        }
+        
+        /** Gets the lock held while forwarding results, so several results can be committed atomically. */
+        std::recursive_timed_mutex& mutex() { return mMutex; }
+        
+    private:
+        TestResult& mResult;                // the result the results are forwarded to
+        std::recursive_timed_mutex mMutex;  // held while forwarding results
+    };
+    
+    /**
+     TestWatchdog monitors the running time of the tests run in the test process, from a background thread.
+     When a test runs longer than its timeout, a failure is reported for this test along with the path of the tests being run, then the run is stopped
+     after processing a partial summary, as a test that does not stop can't be safely aborted. The durations and failed tests of the run are saved 
+     before stopping, the test that timed out being recorded as failed so that it is run first by the next run.
+     The results must be committed through a SynchronizedTestResult object, as the watchdog commits its results from its own thread.
+     @see Test::timeout()
+     @see ntk::TestOptions
+     */
+    class TestWatchdog {
+    public:
+        
+        /** Creates a watchdog reporting timeouts to the specified result, using the default timeout of the specified options. */
+        TestWatchdog(SynchronizedTestResult& result, const TestOptions& options)
+        : mResult(result), mDefaultTimeout(options.timeout), mStopping(false), mTests(NULL), mFilter(NULL), mDurations(NULL), mFailures(NULL),
+          mDurationsFile(options.durationsFile), mFailuresFile(options.failuresFile)
+        {
+            mThread = std::thread(&TestWatchdog::watch, this);
+            active() = this;
+        }
+        
+        /** Stops monitoring the tests and destroys the watchdog. */
+        ~TestWatchdog() {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+            mCondition.notify_all();
+            mThread.join();
+            if (active() == this)
+                active() = NULL;
+        }
+        
+        /** Starts monitoring the specified test, which commits its results to the specified TestResult object. */
+        void testBegins(Test* test, TestResult& result) {
+            unsigned int timeout = test->isSuite() ? 0 : (test->timeout() != 0 ? test->timeout() : mDefaultTimeout);
+            if (timeout == 0)
+                return;
+            
+            std::lock_guard<std::mutex> lock(mMutex);
+            long long now = TestClock::now();
+            mWatches.push_back(Watch(test, &result, timeout, now, now + timeout * 1000000ll));
+            mCondition.notify_all();
+        }
+        
+        /** Stops monitoring the specified test. */
+        void testEnds(Test* test) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (std::vector<Watch>::iterator it = mWatches.begin(); it != mWatches.end(); ++it) {
+                if (it->test == test) {
+                    mWatches.erase(it);
+                    break;
+                }
+            }
+        }
+        
+        /** 
+         Sets the records of the run, saved to the files of the options if a test times out: the durations and failures of the specified tests run
+         with the specified filter. The records are forgotten if the filter is NULL.
+         */
+        void record(const std::vector<Test*>* tests, TestFilter* filter, TestDurations* durations, TestFailures* failures) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTests = tests;
+            mFilter = filter;
+            mDurations = durations;
+            mFailures = failures;
+        }
+        
+        /** Returns true if a watchdog is needed to run the specified tests with the specified options. */
+        static bool isNeeded(const std::vector<Test*>& tests, const TestOptions& options) {
+#ifdef __T_USE_PROCESSES
+            if (options.isolation != TestOptions::NoIsolation)
+                return false;   // timeouts are handled by the process pool
+#endif
+            if (options.timeout != 0)
+                return true;
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                if ((*it)->timeout() != 0)
+                    return true;
+                if ((*it)->isSuite() && isNeeded(static_cast<TestSuite*>(*it)->tests(), options))
+                    return true;
+            }
+            return false;
+        }
+        
+        /** Gets the watchdog used by the current run, or NULL if there is none. */
+        static TestWatchdog*& active() { static TestWatchdog* watchdog = NULL; return watchdog; }
+        
+    private:
+        // a monitored test
+        struct Watch {
+            Watch(Test* theTest, TestResult* theResult, unsigned int theTimeout, long long theStartTime, long long theDeadline) 
+            : test(theTest), result(theResult), timeout(theTimeout), startTime(theStartTime), deadline(theDeadline) 
+            {}
+            Test* test;             // the test being run
+            TestResult* result;     // the result the test commits its results to
+            unsigned int timeout;   // the timeout in milliseconds
+            long long startTime;    // the time the test began
+            long long deadline;     // the time the test times out
+        };
+        
+        // watchdog thread loop
+        void watch() {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mStopping) {
+                long long now = TestClock::now();
+                long long next = std::numeric_limits<long long>::max();
+                for (std::vector<Watch>::iterator it = mWatches.begin(); it != mWatches.end(); ++it) {
+                    if (it->deadline <= now)
+                        timeout(*it);
+                    next = std::min(next, it->deadline);
+                }
+                if (next == std::numeric_limits<long long>::max())
+                    mCondition.wait(lock);
+                else
+                    mCondition.wait_for(lock, std::chrono::nanoseconds(next - now));
+            }
+        }
+        
+        // reports the timeout of a test and stops the run, never returns
+        void timeout(const Watch& watch) {
+            std::ostringstream ss;
+            ss << "Test timed out after " << watch.timeout << " ms while running " << Test::pathOf(watch.test);
+            if (mWatches.size() > 1) {
+                ss << " (also running:";
+                for (std::vector<Watch>::iterator it = mWatches.begin(); it != mWatches.end(); ++it)
+                    if (it->test != watch.test)
+                        ss << " " << Test::pathOf(it->test);
+                ss << ")";
+            }
+            ss << ", stopping the run";
+            
+            // a hung test may be holding the lock forever, in which case the results are committed anyway
+            std::unique_lock<std::recursive_timed_mutex> lock(mResult.mutex(), std::defer_lock);
+            lock.try_lock_for(std::chrono::seconds(1));
+            watch.test->mDuration = TestClock::now() - watch.startTime;
+            if (watch.result != &mResult)
+                mResult.testBegins(watch.test);    // the test is not run on the main thread, its results have not been committed yet
+            mResult.addFailure(TestFailure(ss.str(), watch.test->name(), "unknown file", -1));
+            mResult.testEnds(watch.test);
+            mResult.allTestsEnd();
+            save(watch.test);
+            std::cout.flush();
+            std::cerr.flush();
+            std::_Exit(EXIT_FAILURE);   // the timeout is a failure, and the number of failures could wrap around in the exit status
+        }
+        
+        // saves the records of the run, the specified test that timed out being recorded as failed
+        void save(const Test* test) {
+            if (mFilter == NULL)
+                return;
+            mFilter->testRan(test, true);
+            if (!mDurationsFile.empty()) {
+                mDurations->record(*mTests, *mFilter);
+                mDurations->save(mDurationsFile);
+            }
+            if (!mFailuresFile.empty()) {
+                mFailures->record(*mTests, *mFilter);
+                mFailures->save(mFailuresFile);
+            }
+        }
+        
+        SynchronizedTestResult& mResult;    // the result the timeouts are reported to
+        unsigned int mDefaultTimeout;       // the default timeout in milliseconds
+        bool mStopping;                     // true when the watchdog is being destroyed
+        std::vector<Watch> mWatches;        // the monitored tests
+        std::mutex mMutex;                  // protects the monitored tests
+        std::condition_variable mCondition; // signaled when a test is monitored or the watchdog is stopping
+        std::thread mThread;                // the watchdog thread
+        const std::vector<Test*>* mTests;   // the tests of the run, NULL if the records of the run are not set
+        TestFilter* mFilter;                // the filter of the run
+        TestDurations* mDurations;          // the durations of the run
+        TestFailures* mFailures;            // the failed tests of the run
+        std::string mDurationsFile;         // the file the durations are saved to, if not empty
+        std::string mFailuresFile;          // the file the failed tests are saved to, if not empty
+        
+        // private copy constructor and assign operator as a watchdog can't be copied
+        TestWatchdog(const TestWatchdog&);
+        const TestWatchdog& operator=(const TestWatchdog&);
+    };
+    
+#pragma mark -
+#pragma mark Asynchronous result processing
+    
+    /**
+     AsyncTestResult forwards the test results to another TestResult object from a background thread, so that a slow report (a terminal, a log
+     sink, a large XML document...) does not add to the running time of the tests. The results are queued as compact events in a fixed size ring
+     buffer, in which results are pushed without any lock (waiting only when the buffer is full), and forwarded in order by a single thread.
+     
+     The forwarded results keep referencing the tests reported, so tests must not be run again nor destroyed until their results are forwarded:
+     drain() waits until all the queued results have been forwarded, and is called by the runner when needed (and by allTestsEnd()). The results
+     of this object itself, such as its failure count, are updated synchronously. Results should be committed from one thread at a time, for
+     example through a SynchronizedTestResult, as Test::runAll() does: only the queue supports several threads pushing results concurrently.
+     @see ntk::TestOptions
+     */
+    class AsyncTestResult : public TestResult
+    {
+    public:
+        
+        /** Creates a new asynchronous result forwarding the results to the specified TestResult object, queuing at most capacity results. */
+        AsyncTestResult(TestResult& result, size_t capacity = 4096)
+        : mResult(result), mCapacity(roundUp(capacity)), mSlots(new Slot[mCapacity]), mTail(0), mHead(0), mConsumerWaiting(false), mDrainers(0)
+        {
+            for (size_t i = 0; i < mCapacity; ++i)
+                mSlots[i].sequence.store(i, std::memory_order_relaxed);
+            mThread = std::thread(&AsyncTestResult::consume, this);
+        }
+        
+        /** Forwards the queued results and destroys the result. */
+        virtual ~AsyncTestResult() {
+            push(Event::Stop, NULL);
+            mThread.join();
+        }
+        
+        /** This method is called before running all tests. */
+        virtual void allTestsBegin() {
+            TestResult::allTestsBegin();
+            push(Event::AllBegin, NULL);
+        }
+        
+        /** This method is called after all tests have been run, it returns once all the results have been forwarded. */
+        virtual void allTestsEnd() {
+            TestResult::allTestsEnd();
+            push(Event::AllEnd, NULL);
+            drain();
+        }
+        
+        /** This method is called each time a test begins. */
+        virtual void testBegins(Test* test) {
+            TestResult::testBegins(test);
+            push(Event::Begin, test);
+        }
+        
+        /** This method is called each time a test ends. */
+        virtual void testEnds(Test* test) {
+            TestResult::testEnds(test);
+            push(Event::End, test);
+        }
+        
+        /** This method is called when a test has failed. */
+        virtual void addFailure(const TestFailure& failure) {
+            TestResult::addFailure(failure);
+            TestAllocations::Pause pause;
+            push(Event::Failure, NULL, new TestFailure(failure));
+        }
+        
+        /** This method is called when a benchmark has completed its measures. */
+        virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+            TestResult::benchmarkResult(test, stats);
+            TestAllocations::Pause pause;
+            push(Event::Benchmark, test, new TestBenchmarkStats(stats));
+        }
+        
+        /** This method is called when a test case ends, with its heap allocations if they are tracked. */
+        virtual void allocationResult(Test* test, const TestAllocationStats& stats) {
+            TestResult::allocationResult(test, stats);
+            TestAllocations::Pause pause;
+            push(Event::Allocations, test, new TestAllocationStats(stats));
+        }
+        
+        /** This method is called when a test case or the samples of a benchmark have been measured, with their hardware events if they are counted. */
+        virtual void counterResult(Test* test, const TestCounterStats& stats) {
+            TestResult::counterResult(test, stats);
+            TestAllocations::Pause pause;
+            push(Event::Counters, test, new TestCounterStats(stats));
+        }
+        
+        /** This method is called when a test case ends, once per assertion site it checked if checks are profiled. */
+        virtual void checkResult(Test* test, const TestCheckStats& stats) {
+            TestResult::checkResult(test, stats);
+            TestAllocations::Pause pause;
+            push(Event::Checks, test, new TestCheckStats(stats));
+        }
+        
+        /** Waits until all the results queued so far have been forwarded. */
+        virtual void drain() {
+            size_t target = mTail.load();
+            std::unique_lock<std::mutex> lock(mMutex);
+            ++mDrainers;
+            while (mHead.load() < target)
+                mForwarded.wait(lock);
+            --mDrainers;
+        }
+        
+    private:
+        // a queued result, the failure or statistics being copied
+        struct Event {
+            enum Type { AllBegin, AllEnd, Begin, End, Failure, Benchmark, Allocations, Counters, Checks, Stop };
+            Type type;
+            Test* test;
+            void* data;     // the copy of the failure or of the statistics, owned by the event
+        };
+        
+        // a slot of the ring buffer, its sequence tells whether it holds an event for the current round of the ring
+        struct Slot {
+            std::atomic<size_t> sequence;
+            Event event;
+        };
+        
+        // rounds up the capacity to a power of 2
+        static size_t roundUp(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity)
+                size *= 2;
+            return size;
+        }
+        
+        // queues an event, from any thread
+        void push(Event::Type type, Test* test, void* data = NULL) {
+            size_t position = mTail.load(std::memory_order_relaxed);
+            Slot* slot;
+            for (;;) {
+                slot = &mSlots[position & (mCapacity - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                if ((sequence == position) && mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;      // the slot is claimed
+                if (sequence < position) {
+                    std::this_thread::yield();     // the buffer is full, wait for the consumer
+                    position = mTail.load(std::memory_order_relaxed);
+                } else if (sequence > position) {
+                    position = mTail.load(std::memory_order_relaxed);  // claimed by another thread
+                }
+            }
+            slot->event.type = type;
+            slot->event.test = test;
+            slot->event.data = data;
+            slot->sequence.store(position + 1);
+            if (mConsumerWaiting.load()) {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mEventAvailable.notify_one();
+            }
+        }
+        
+        // background thread loop, forwarding the events in order
+        void consume() {
+            for (;;) {
+                size_t position = mHead.load(std::memory_order_relaxed);
+                Slot& slot = mSlots[position & (mCapacity - 1)];
+                if (slot.sequence.load() != position + 1) {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mConsumerWaiting.store(true);
+                    if (slot.sequence.load() != position + 1)
+                        mEventAvailable.wait(lock);
+                    mConsumerWaiting.store(false);
+                    continue;
+                }
+                
+                Event event = slot.event;
+                slot.sequence.store(position + mCapacity, std::memory_order_release);     // the slot is free for the next round
+                forward(event);
+                mHead.store(position + 1);
+                if (mDrainers.load() != 0) {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mForwarded.notify_all();
+                }
+                if (event.type == Event::Stop)
+                    return;
+            }
+        }
+        
+        // forwards an event to the result, releasing its data
+        void forward(const Event& event) {
+            switch (event.type) {
+                case Event::AllBegin:   mResult.allTestsBegin();    break;
+                case Event::AllEnd:     mResult.allTestsEnd();      break;
+                case Event::Begin:      mResult.testBegins(event.test); break;
+                case Event::End:        mResult.testEnds(event.test);   break;
+                case Event::Failure:    mResult.addFailure(*std::unique_ptr<TestFailure>(static_cast<TestFailure*>(event.data)));     break;
+                case Event::Benchmark:  
+                    mResult.benchmarkResult(event.test, *std::unique_ptr<TestBenchmarkStats>(static_cast<TestBenchmarkStats*>(event.data)));
+                    break;
+                case Event::Allocations:
+                    mResult.allocationResult(event.test, *std::unique_ptr<TestAllocationStats>(static_cast<TestAllocationStats*>(event.data)));
+                    break;
+                case Event::Counters:
+                    mResult.counterResult(event.test, *std::unique_ptr<TestCounterStats>(static_cast<TestCounterStats*>(event.data)));
+                    break;
+                case Event::Checks:
+                    mResult.checkResult(event.test, *std::unique_ptr<TestCheckStats>(static_cast<TestCheckStats*>(event.data)));
+                    break;
+                case Event::Stop:       break;
+            }
+        }
+        
+        TestResult& mResult;                    // the result the results are forwarded to
+        size_t mCapacity;                       // the number of slots of the ring buffer, a power of 2
+        std::unique_ptr<Slot[]> mSlots;         // the ring buffer
+        std::atomic<size_t> mTail;              // the position of the next event pushed
+        std::atomic<size_t> mHead;              // the position of the next event forwarded, i.e. the number of events forwarded
+        std::atomic<bool> mConsumerWaiting;     // true while the background thread waits for an event
+        std::atomic<int> mDrainers;             // the number of threads waiting for the events to be forwarded
+        std::mutex mMutex;                      // protects the waits
+        std::condition_variable mEventAvailable;// signaled when an event is pushed while the background thread waits
+        std::condition_variable mForwarded;     // signaled when an event is forwarded while a thread drains the queue
+        std::thread mThread;                    // the background thread
+        
+        // private copy constructor and assign operator as an asynchronous result can't be copied
+        AsyncTestResult(const AsyncTestResult&);
+        const AsyncTestResult& operator=(const AsyncTestResult&);
+    };
+    
+#endif // DO_NOT_USE_THREADS
+    
+#ifdef __T_USE_PROCESSES
+    
+#pragma mark -
+#pragma mark Process isolated test execution
+    
+    /**
+     TestProcessPool runs test cases in child processes, so that a crash only affects the test that caused it.
+     Each job (a test case or the test cases of a suite, depending on the isolation mode) is run in a forked child process, which streams the test results
+     back to the test process through a pipe. Up to the configured number of jobs are run concurrently. The results are recorded and committed once the 
+     main thread reaches the test while walking the test tree, so results are always processed in declaration order.
+     
+     If a child process dies or times out while running a test, a failure is reported for this test and the remaining tests of the job are run in a new 
+     child process. Serial jobs are never run concurrently with other jobs. Jobs with prioritized tests are run first, then if recorded durations are
+     available, the longest jobs are run first.
+     @see Test::runAll()
+     */
+    class TestProcessPool {
+    public:
+        
+        /** Creates a pool running the specified tests in child processes, using the specified options and recorded durations. */
+        TestProcessPool(const std::vector<Test*>& tests, const TestOptions& options, const TestDurations& durations = TestDurations())
+        : mMaxRunning(options.jobs), mDefaultTimeout(options.timeout), mCancelled(false)
+        {
+            if (options.isolation == TestOptions::NoIsolation)
+                return;
+            if (mMaxRunning == 0)
+                mMaxRunning = (size_t)std::max(1l, ::sysconf(_SC_NPROCESSORS_ONLN));
+            
+            schedule(tests, "", options.isolation == TestOptions::IsolateSuites, false, durations);
+            std::stable_sort(mQueue.begin(), mQueue.end(), Job::runsBefore);
+            active() = this;
+        }
+        
+        /** Kills the remaining child processes if any, and destroys the pool. */
+        ~TestProcessPool() {
+            for (std::vector<Job*>::iterator it = mRunning.begin(); it != mRunning.end(); ++it) {
+                ::kill((*it)->pid, SIGKILL);
+                ::waitpid((*it)->pid, NULL, 0);
+                ::close((*it)->fd);
+                delete *it;
+            }
+            for (std::deque<Job*>::iterator it = mQueue.begin(); it != mQueue.end(); ++it)
+                delete *it;
+            for (std::map<Test*, Entry*>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+                delete it->second;
+            if (active() == this)
+                active() = NULL;
+        }
+        
+        /** 
+         Commits the results of the specified test if it was scheduled, waiting for it to complete if needed. 
+         Returns false if the test was not scheduled in this pool.
+         */
+        bool replay(Test* test, TestResult& result) {
+            std::map<Test*, Entry*>::iterator it = mEntries.find(test);
+            if (it == mEntries.end())
+                return false;
+            
+            Entry* entry = it->second;
+            while (!entry->done)
+                pump();
+            entry->recorder.replay(result);
+            mEntries.erase(it);
+            delete entry;
+            return true;
+        }
+        
+        /** Waits until all the scheduled tests have been run. */
+        void waitIdle() {
+            while (!mQueue.empty() || !mRunning.empty())
+                pump();
+        }
+        
+        /** Cancels the scheduled tests that have not been started yet, they will not be replayed. */
+        void cancel() {
+            for (std::deque<Job*>::iterator it = mQueue.begin(); it != mQueue.end(); ++it)
+                delete *it;
+            mQueue.clear();
+            mCancelled = true;
+        }
+        
+        /** Gets the pool used by the current run, or NULL if tests are not isolated. */
+        static TestProcessPool*& active() { static TestProcessPool* pool = NULL; return pool; }
+        
+    private:
+        // the recorded results of a scheduled test
+        struct Entry {
+            Entry() : done(false) {}
+            TestRecorder recorder;
+            bool done;
+        };
+        
+        // a group of tests run in the same child process
+        struct Job {
+            Job(bool isSerial) 
+            : serial(isSerial), prioritized(false), duration(0), pid(-1), fd(-1), current(-1), currentCase(NULL), ended(0), startTime(0), timeout(0), 
+              deadline(0), timedOut(false) 
+            {}
+            static bool runsBefore(const Job* job, const Job* other) {
+                return (job->prioritized != other->prioritized) ? job->prioritized : (job->duration > other->duration);
+            }
+            std::vector<Test*> tests;   // the tests to run
+            bool serial;                // true if the job must not run concurrently with other jobs
+            bool prioritized;           // true if the job contains prioritized tests
+            long long duration;         // the expected duration
+            pid_t pid;                  // the child process
+            int fd;                     // the read end of the results pipe
+            std::string buffer;         // the data received and not yet processed
+            int current;                // the index of the test being run, -1 if none
+            Test* currentCase;          // the case being run if the test is a batch, NULL if none
+            size_t ended;               // the number of tests that have ended
+            long long startTime;        // the start time of the current test
+            unsigned int timeout;       // the timeout of the current test in milliseconds, 0 if none
+            long long deadline;         // the time the current test times out
+            bool timedOut;              // true if the child process has been killed because of a timeout
+        };
+        
+        // streams the results of a child process to the test process
+        class PipeWriter : public TestResult {
+        public:
+            PipeWriter(int fd, const std::vector<Test*>& tests) : mFd(fd), mTests(tests), mCurrent(0) {}
+            
+            // runs the test of the job with the specified index, a batch being only reported as its cases
+            void run(size_t index) {
+                mCurrent = index;
+                if (mTests[index]->type() == TestType::TestBatch)
+                    send('B', field(index));
+                mTests[index]->run(*this);
+                if (mTests[index]->type() == TestType::TestBatch)
+                    send('E', field(index) + field(mTests[index]->duration()));
+            }
+            
+            // the tests that are not part of the job are the cases of the batch being run
+            virtual void testBegins(Test* test) { 
+                if (isCase(test))
+                    send('b', field(mCurrent) + field(test->name()));
+                else
+                    send('B', index(test)); 
+            }
+            virtual void testEnds(Test* test) { send(isCase(test) ? 'e' : 'E', (isCase(test) ? field(mCurrent) : index(test)) + field(test->duration())); }
+            
+            virtual void addFailure(const TestFailure& failure) {
+                TestResult::addFailure(failure);
+                send('F', field(failure.condition()) + field(std::string(failure.testName())) + field(std::string(failure.fileName())) 
+                          + field(failure.line()));
+            }
+            
+            virtual void benchmarkResult(Test* test, const TestBenchmarkStats& stats) {
+                std::string sampleTimes = field(stats.sampleTimes.size());
+                for (std::vector<double>::const_iterator it = stats.sampleTimes.begin(); it != stats.sampleTimes.end(); ++it)
+                    sampleTimes += field(*it);
+                send('S', field(stats.iterations) + field(stats.samples) + field(stats.min) + field(stats.median) + field(stats.p99) 
+                          + field(stats.mean) + field(stats.stddev) + sampleTimes);
+            }
+            
+            virtual void allocationResult(Test* test, const TestAllocationStats& stats) {
+                send('A', field(stats.allocations) + field(stats.deallocations) + field(stats.bytes) + field(stats.peakBytes) 
+                          + field(stats.retainedBytes));
+            }
+            
+            virtual void counterResult(Test* test, const TestCounterStats& stats) {
+                send('C', field(stats.operations) + field(stats.cycles) + field(stats.instructions) + field(stats.cacheReferences) 
+                          + field(stats.cacheMisses) + field(stats.branches) + field(stats.branchMisses));
+            }
+            
+            virtual void checkResult(Test* test, const TestCheckStats& stats) {
+                send('K', field(stats.file) + field(stats.line) + field(stats.count) + field(stats.duration));
+            }
+            
+        private:
+            // gets the index field of a test of the job
+            std::string index(Test* test) const {
+                return field((long long)(std::find(mTests.begin(), mTests.end(), test) - mTests.begin()));
+            }
+            
+            // returns true if a test is a case of the batch being run
+            bool isCase(Test* test) const { return (test != mTests[mCurrent]) && (mTests[mCurrent]->type() == TestType::TestBatch); }
+            
+            // sends a message made of a type and encoded fields, unbuffered so nothing is lost if the process crashes
+            void send(char type, const std::string& fields) {
+                std::string payload = type + fields;
+                std::ostringstream ss;
+                ss << payload.size() << ":" << payload;
+                std::string message = ss.str();
+                const char* data = message.data();
+                size_t size = message.size();
+                while (size > 0) {
+                    ssize_t written = ::write(mFd, data, size);
+                    if (written < 0) {
+                        if (errno == EINTR)
+                            continue;
+                        ::_exit(EXIT_FAILURE);
+                    }
+                    data += written;
+                    size -= written;
+                }
+            }
+            
+            int mFd;
+            const std::vector<Test*>& mTests;
+            size_t mCurrent;
+        };
+        
+        // encodes a message field
+        static std::string field(const std::string& value) {
+            std::ostringstream ss;
+            ss << value.size() << ":" << value;
+            return ss.str();
+        }
+        
+        // encodes a numeric message field
+        template <typename T>
+        static std::string field(T value) {
+            std::ostringstream ss;
+            ss << std::setprecision(17) << value;
+            return field(ss.str());
+        }
+        
+        // decodes the next field of a message, returns false if the message is incomplete
+        static bool nextField(const std::string& data, size_t& pos, std::string& value) {
+            size_t separator = data.find(':', pos);
+            if (separator == std::string::npos)
+                return false;
+            size_t size = (size_t)std::strtoul(data.c_str() + pos, NULL, 10);
+            if (data.size() < separator + 1 + size)
+                return false;
+            value = data.substr(separator + 1, size);
+            pos = separator + 1 + size;
+            return true;
+        }
+        
+        // decodes the next numeric field of a message
+        template <typename T>
+        static T nextValue(const std::string& data, size_t& pos) {
+            std::string value;
+            T result = T();
+            if (nextField(data, pos, value))
+                std::istringstream(value) >> result;
+            return result;
+        }
+        
+        // schedules the test cases, one job per test or one job per suite depending on the isolation mode
+        void schedule(const std::vector<Test*>& tests, const std::string& parentPath, bool isolateSuites, bool serial, 
+                      const TestDurations& durations) {
+            Job* suiteJob = NULL;
+            for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+                std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+                if (!TestFilter::accepts(*it)) {
+                    continue;
+                } else if ((*it)->isSuite()) {
+                    TestSuite* suite = static_cast<TestSuite*>(*it);
+                    schedule(suite->tests(), path, isolateSuites, serial || suite->isSerial(), durations);
+                } else if (mEntries.find(*it) == mEntries.end()) {
+                    long long duration = durations.empty() ? 0 : durations.estimate(path);
+                    mEntries[*it] = new Entry();
+                    if (isolateSuites && (suiteJob != NULL)) {
+                        suiteJob->tests.push_back(*it);
+                        suiteJob->serial = suiteJob->serial || (*it)->isSerial();
+                        suiteJob->prioritized = suiteJob->prioritized || TestFilter::prioritizes(*it);
+                        suiteJob->duration += duration;
+                        continue;
+                    }
+                    Job* job = new Job(serial || (*it)->isSerial());
+                    job->tests.push_back(*it);
+                    job->prioritized = TestFilter::prioritizes(*it);
+                    job->duration = duration;
+                    mQueue.push_back(job);
+                    if (isolateSuites)
+                        suiteJob = job;
+                }
+            }
+        }
+        
+        // starts jobs if possible, then processes the results received from the running jobs
+        void pump() {
+            while (!mQueue.empty() && (mRunning.size() < mMaxRunning)) {
+                if (!mRunning.empty() && (mQueue.front()->serial || mRunning.front()->serial))
+                    break;
+                Job* job = mQueue.front();
+                mQueue.pop_front();
+                start(job);
+            }
+            if (mRunning.empty())
+                return;
+            
+            std::vector<pollfd> fds(mRunning.size());
+            for (size_t i = 0; i < mRunning.size(); ++i) {
+                fds[i].fd = mRunning[i]->fd;
+                fds[i].events = POLLIN;
+                fds[i].revents = 0;
+            }
+            
+            // wait for results until the next deadline
+            long long now = TestClock::now();
+            long long next = std::numeric_limits<long long>::max();
+            for (std::vector<Job*>::iterator it = mRunning.begin(); it != mRunning.end(); ++it)
+                if ((*it)->timeout != 0)
+                    next = std::min(next, (*it)->deadline);
+            int wait = (next == std::numeric_limits<long long>::max()) ? -1 : (int)std::max(0ll, (next - now + 999999) / 1000000);
+            if ((::poll(&fds[0], fds.size(), wait) < 0) && (errno != EINTR))
+                return;
+            
+            std::vector<Job*> running = mRunning;
+            for (size_t i = 0; i < running.size(); ++i) {
+                if (fds[i].revents == 0)
+                    continue;
+                char data[4096];
+                ssize_t size = ::read(running[i]->fd, data, sizeof(data));
+                if (size > 0) {
+                    running[i]->buffer.append(data, size);
+                    process(running[i]);
+                } else if ((size == 0) || (errno != EINTR)) {
+                    finish(running[i]);
+                }
+            }
+            
+            // abort the tests that have timed out
+            now = TestClock::now();
+            running = mRunning;
+            for (std::vector<Job*>::iterator it = running.begin(); it != running.end(); ++it) {
+                if (((*it)->timeout != 0) && ((*it)->deadline <= now)) {
+                    ::kill((*it)->pid, SIGKILL);
+                    (*it)->timedOut = true;
+                    finish(*it);
+                }
+            }
+        }
+        
+        // runs a job in a new child process
+        void start(Job* job) {
+            int fds[2];
+            pid_t pid = -1;
+            std::cout.flush();      // do not duplicate pending output in the child process
+            std::cerr.flush();
+            std::fflush(NULL);
+            if (::pipe(fds) == 0) {
+                pid = ::fork();
+                if (pid < 0) {
+                    ::close(fds[0]);
+                    ::close(fds[1]);
+                }
+            }
+            
+            if (pid < 0) {
+                // unable to isolate the tests, run them in the test process
+                for (std::vector<Test*>::iterator it = job->tests.begin(); it != job->tests.end(); ++it) {
+                    Entry* entry = mEntries[*it];
+                    (*it)->run(entry->recorder);
+                    entry->done = true;
+                }
+                delete job;
+                return;
+            }
+            
+            if (pid == 0) {
+                // child process: run the tests and exit without running any destructor
+                ::close(fds[0]);
+                active() = NULL;
+                PipeWriter writer(fds[1], job->tests);
+                for (size_t i = 0; i < job->tests.size(); ++i)
+                    writer.run(i);
+                std::cout.flush();
+                std::cerr.flush();
+                std::fflush(NULL);
+                ::_exit(EXIT_SUCCESS);
+            }
+            
+            ::close(fds[1]);
+            job->pid = pid;
+            job->fd = fds[0];
+            mRunning.push_back(job);
+        }
+        
+        // processes the complete messages received from a job
+        void process(Job* job) {
+            size_t pos = 0;
+            for (;;) {
+                size_t start = pos;
+                std::string message;
+                if (!nextField(job->buffer, pos, message)) {
+                    pos = start;
+                    break;
+                }
+                
+                size_t fieldPos = 1;
+                switch (message.empty() ? 0 : message[0]) {
+                    case 'B': {
+                        job->current = nextValue<int>(message, fieldPos);
+                        Test* test = job->tests[job->current];
+                        job->startTime = TestClock::now();
+                        job->timeout = (test->timeout() != 0) ? test->timeout() : mDefaultTimeout;
+                        job->deadline = job->startTime + job->timeout * 1000000ll;
+                        if (test->type() != TestType::TestBatch)
+                            mEntries[test]->recorder.testBegins(test);
+                        break;
+                    }
+                    case 'E': {
+                        Test* test = job->tests[nextValue<int>(message, fieldPos)];
+                        test->mDuration = nextValue<long long>(message, fieldPos);
+                        end(job, test);
+                        break;
+                    }
+                    case 'b': {
+                        job->current = nextValue<int>(message, fieldPos);
+                        std::string name;
+                        nextField(message, fieldPos, name);
+                        Test* test = job->tests[job->current];
+                        job->currentCase = &static_cast<TestBatch*>(test)->addCase(name);
+                        job->startTime = TestClock::now();
+                        job->timeout = (test->timeout() != 0) ? test->timeout() : mDefaultTimeout;
+                        job->deadline = job->startTime + job->timeout * 1000000ll;
+                        mEntries[test]->recorder.testBegins(job->currentCase);
+                        break;
+                    }
+                    case 'e': {
+                        Test* test = job->tests[nextValue<int>(message, fieldPos)];
+                        if (job->currentCase != NULL) {
+                            job->currentCase->mDuration = nextValue<long long>(message, fieldPos);
+                            mEntries[test]->recorder.testEnds(job->currentCase);
+                        }
+                        job->currentCase = NULL;
+                        job->timeout = 0;
+                        break;
+                    }
+                    case 'F': {
+                        std::string condition, testName, fileName;
+                        nextField(message, fieldPos, condition);
+                        nextField(message, fieldPos, testName);
+                        nextField(message, fieldPos, fileName);
+                        int line = nextValue<int>(message, fieldPos);
+                        if (job->current >= 0)
+                            mEntries[job->tests[job->current]]->recorder.addFailure(TestFailure(condition, testName, fileName, line));
+                        break;
+                    }
+                    case 'S':
+                        if (job->current >= 0) {
+                            TestBenchmarkStats stats;
+                            stats.iterations = nextValue<long long>(message, fieldPos);
+                            stats.samples = nextValue<int>(message, fieldPos);
+                            stats.min = nextValue<double>(message, fieldPos);
+                            stats.median = nextValue<double>(message, fieldPos);
+                            stats.p99 = nextValue<double>(message, fieldPos);
+                            stats.mean = nextValue<double>(message, fieldPos);
+                            stats.stddev = nextValue<double>(message, fieldPos);
+                            stats.sampleTimes.resize(nextValue<size_t>(message, fieldPos));
+                            for (size_t i = 0; i < stats.sampleTimes.size(); ++i)
+                                stats.sampleTimes[i] = nextValue<double>(message, fieldPos);
+                            mEntries[job->tests[job->current]]->recorder.benchmarkResult(job->tests[job->current], stats);
+                        }
+                        break;
+                    case 'A':
+                        if (job->current >= 0) {
+                            TestAllocationStats stats;
+                            stats.allocations = nextValue<long long>(message, fieldPos);
+                            stats.deallocations = nextValue<long long>(message, fieldPos);
+                            stats.bytes = nextValue<long long>(message, fieldPos);
+                            stats.peakBytes = nextValue<long long>(message, fieldPos);
+                            stats.retainedBytes = nextValue<long long>(message, fieldPos);
+                            mEntries[job->tests[job->current]]->recorder.allocationResult(job->tests[job->current], stats);
+                        }
+                        break;
+                    case 'C':
+                        if (job->current >= 0) {
+                            TestCounterStats stats;
+                            stats.operations = nextValue<long long>(message, fieldPos);
+                            stats.cycles = nextValue<double>(message, fieldPos);
+                            stats.instructions = nextValue<double>(message, fieldPos);
+                            stats.cacheReferences = nextValue<double>(message, fieldPos);
+                            stats.cacheMisses = nextValue<double>(message, fieldPos);
+                            stats.branches = nextValue<double>(message, fieldPos);
+                            stats.branchMisses = nextValue<double>(message, fieldPos);
+                            mEntries[job->tests[job->current]]->recorder.counterResult(job->tests[job->current], stats);
+                        }
+                        break;
+                    case 'K':
+                        if (job->current >= 0) {
+                            std::string file;
+                            nextField(message, fieldPos, file);
+                            TestCheckStats stats(file, nextValue<int>(message, fieldPos));
+                            stats.count = nextValue<long long>(message, fieldPos);
+                            stats.duration = nextValue<long long>(message, fieldPos);
+                            mEntries[job->tests[job->current]]->recorder.checkResult(job->tests[job->current], stats);
+                        }
+                        break;
+                }
+            }
+            job->buffer.erase(0, pos);
+        }
+        
+        // commits the end of a test of a job
+        void end(Job* job, Test* test) {
+            Entry* entry = mEntries[test];
+            if (test->type() != TestType::TestBatch)
+                entry->recorder.testEnds(test);     // only the cases of a batch are reported
+            entry->done = true;
+            job->current = -1;
+            job->timeout = 0;
+            ++job->ended;
+        }
+        
+        // processes the termination of a job, reporting a failure if its child process has died while running a test
+        void finish(Job* job) {
+            int status = 0;
+            while ((::waitpid(job->pid, &status, 0) < 0) && (errno == EINTR)) {}
+            ::close(job->fd);
+            mRunning.erase(std::find(mRunning.begin(), mRunning.end(), job));
+            
+            if (job->ended < job->tests.size()) {
+                std::ostringstream ss;
+                if (job->timedOut)
+                    ss << "Test timed out after " << job->timeout << " ms";
+                else if (WIFSIGNALED(status))
+                    ss << "Test process crashed with signal " << WTERMSIG(status) << " (" << ::strsignal(WTERMSIG(status)) << ")";
+                else
+                    ss << "Test process exited unexpectedly with status " << WEXITSTATUS(status);
+                
+                // the test being run is failed, or the next one if the process died between tests
+                Test* test = job->tests[(job->current >= 0) ? job->current : job->ended];
+                Entry* entry = mEntries[test];
+                if (test->type() == TestType::TestBatch) {
+                    // the case being run is failed, the remaining cases of the batch are skipped
+                    if (job->currentCase != NULL) {
+                        entry->recorder.addFailure(TestFailure(ss.str(), job->currentCase->name(), "unknown file", -1));
+                        job->currentCase->mDuration = TestClock::now() - job->startTime;
+                        entry->recorder.testEnds(job->currentCase);
+                    } else {
+                        entry->recorder.addFailure(TestFailure(ss.str(), test->name(), "unknown file", -1));
+                    }
+                    job->currentCase = NULL;
+                    end(job, test);
+                } else {
+                    if (job->current < 0) {
+                        entry->recorder.testBegins(test);
+                        job->startTime = TestClock::now();
+                    }
+                    entry->recorder.addFailure(TestFailure(ss.str(), test->name(), "unknown file", -1));
+                    test->mDuration = TestClock::now() - job->startTime;
+                    end(job, test);
+                }
+                
+                // the remaining tests are run in a new child process
+                if ((job->ended < job->tests.size()) && !mCancelled) {
+                    Job* remaining = new Job(job->serial);
+                    remaining->tests.assign(job->tests.begin() + job->ended, job->tests.end());
+                    mQueue.push_front(remaining);
+                }
+            }
+            delete job;
+        }
+        
+        std::map<Test*, Entry*> mEntries;   // the recorded results of the scheduled tests not yet replayed
+        std::deque<Job*> mQueue;            // the jobs waiting to be run
+        std::vector<Job*> mRunning;         // the jobs being run
+        size_t mMaxRunning;                 // the maximum number of jobs run concurrently
+        unsigned int mDefaultTimeout;       // the default timeout of the tests in milliseconds
+        bool mCancelled;                    // true if the tests not started yet have been cancelled
+        
+        // private copy constructor and assign operator as a pool can't be copied
+        TestProcessPool(const TestProcessPool&);
+        const TestProcessPool& operator=(const TestProcessPool&);
+    };
+    
+#endif // __T_USE_PROCESSES
+    
+    /**
+     TestTree builds the tree of the tests declared with the helper macros from their descriptors (see ntk::TestRegistry), in declaration order: 
+     test cases are added to the last suite declared before them in the same file, or to the suite of the last suite path declared before them, which
+     may be declared in any file. The tree is made of the declared tests, created on first use, or of placeholders named after their descriptors
+     when the tests are only listed, so that no test constructor is run except for the parameterized tests, whose cases are only known once created.
+     @see Test::listAll()
+     */
+    class TestTree {
+    public:
+        
+        /** Adds the declared tests, or placeholders standing for them, to the specified test set. */
+        TestTree(std::vector<Test*>& tests, bool usePlaceholders) : mTests(tests), mUsePlaceholders(usePlaceholders) {
+            std::vector<const TestDescriptor*> descriptors = TestRegistry::descriptors();
+            for (std::vector<const TestDescriptor*>::const_iterator it = descriptors.begin(); it != descriptors.end(); ++it)
+                if ((*it)->instance != NULL)
+                    mDescriptors.insert(std::make_pair((*it)->instance, *it));
+            
+            // tests following a suite path are added last, so that the path can refer to suites declared in any file
+            std::vector<std::pair<const char*, Test*> > pathTests;
+            const char* file = NULL;
+            const char* path = NULL;
+            TestSuite* suite = NULL;
+            for (std::vector<const TestDescriptor*>::const_iterator it = descriptors.begin(); it != descriptors.end(); ++it) {
+                const TestDescriptor* descriptor = *it;
+                if ((file == NULL) || (std::strcmp(file, descriptor->file) != 0)) {
+                    file = descriptor->file;
+                    path = NULL;
+                    suite = NULL;
+                }
+                if (descriptor->kind == TestDescriptor::SuitePath) {
+                    path = descriptor->name;
+                    continue;
+                }
+                
+                bool isNew = mPlaced.insert(descriptor->instance).second;   // the same test may be declared in several files
+                Test& test = testOf(descriptor->instance);
+                switch (descriptor->kind) {
+                    case TestDescriptor::Suite:
+                        if (isNew)
+                            mTests.push_back(&test);
+                        path = NULL;
+                        suite = static_cast<TestSuite*>(&test);
+                        break;
+                    case TestDescriptor::SubSuite:
+                        if (isNew)
+                            static_cast<TestSuite&>(testOf(descriptor->parentInstance)).addTest(&test);
+                        path = NULL;
+                        suite = static_cast<TestSuite*>(&test);
+                        break;
+                    default:
+                        if (!isNew)
+                            break;
+                        if (path != NULL) {
+                            pathTests.push_back(std::make_pair(path, &test));
+                            break;
+                        }
+                        if (suite == NULL)
+                            suite = &suiteAtPath("DefaultTestSuite");
+                        suite->addTest(&test);
+                        break;
+                }
+            }
+            for (std::vector<std::pair<const char*, Test*> >::const_iterator it = pathTests.begin(); it != pathTests.end(); ++it)
+                suiteAtPath(it->first).addTest(it->second);
+        }
+        
+        /** Gets the tests of the tree standing for the declared tests, by the function creating the declared test. */
+        const TestRegistry::Tests& declared() const { return mDeclared; }
+        
+    private:
+        // a test case standing for a declared test case
+        class Placeholder : public Test {
+        public:
+            Placeholder(const char* name) : Test(StaticName(name)) {}
+        protected:
+            virtual void runTest(TestResult& result) {}
+        };
+        
+        // gets the test standing for the declared test created by the specified function, creating it or its placeholder on first use
+        Test& testOf(Test& (*instance)()) {
+            TestRegistry::Tests::iterator it = mDeclared.find(instance);
+            if (it != mDeclared.end())
+                return *it->second;
+            const TestDescriptor* descriptor = mDescriptors[instance];
+            Test* test;
+            if (!mUsePlaceholders || (descriptor == NULL) || (descriptor->kind == TestDescriptor::ParameterizedTest))
+                test = &instance();
+            else if (descriptor->kind == TestDescriptor::TestCase)
+                test = &*mPlaceholders.emplace(mPlaceholders.end(), descriptor->name);
+            else
+                test = &*mSuites.emplace(mSuites.end(), Test::StaticName(descriptor->name), TestType::TestSuite, false);
+            mDeclared[instance] = test;
+            return *test;
+        }
+        
+        // gets the suite with the specified path in the test set, suites are matched by name so that any file can add tests to a suite
+        TestSuite& suiteAtPath(const std::string& path) {
+            TestSuite* suite = NULL;
+            size_t begin = 0;
+            while (begin <= path.size()) {
+                size_t end = std::min(path.find('/', begin), path.size());
+                std::string name = path.substr(begin, end - begin);
+                begin = end + 1;
+                if (name.empty())
+                    continue;   // ignore repeated or trailing separators
+                
+                const std::vector<Test*>& tests = (suite != NULL) ? suite->tests() : mTests;
+                TestSuite* child = NULL;
+                for (std::vector<Test*>::const_iterator it = tests.begin(); (child == NULL) && (it != tests.end()); ++it)
+                    if ((*it)->isSuite() && ((*it)->name() == name))
+                        child = static_cast<TestSuite*>(*it);
+                if (child == NULL) {
+                    child = &*mSuites.emplace(mSuites.end(), name, TestType::TestSuite, false);
+                    if (suite != NULL)
+                        suite->addTest(child);
+                    else
+                        mTests.push_back(child);
+                }
+                suite = child;
+            }
+            return (suite != NULL) ? *suite : suiteAtPath("DefaultTestSuite");
+        }
+        
+        std::vector<Test*>& mTests;     // the test set the declared tests are added to
+        bool mUsePlaceholders;          // true to add placeholders instead of the declared tests, except the parameterized tests
+        std::map<Test& (*)(), const TestDescriptor*> mDescriptors;  // the descriptors of the declared tests, by the function creating the test
+        std::set<Test& (*)()> mPlaced;  // the declared tests already added to the tree
+        TestRegistry::Tests mDeclared;  // the tests of the tree standing for the declared tests
+        std::list<TestSuite> mSuites;   // the suites only declared by their path, and the placeholders of the declared suites
+        std::list<Placeholder> mPlaceholders;   // the placeholders of the declared test cases
+    };
+    
+#pragma mark -
+#pragma mark Test inline implementation
+    
+    // runs the test, using the specified Test::Result object to process the test results.
+    inline int Test::run(TestResult& result) {
+        int failuresBeforeTest = result.failures();
+        
+        result.testBegins(this);
+#ifndef DO_NOT_USE_THREADS
+        TestWatchdog* watchdog = TestWatchdog::active();
+        if (watchdog != NULL)
+            watchdog->testBegins(this, result);
+#endif
+        TestAllocations::Counters allocations = TestAllocations::start();
+        TestCounters::Counts counts = TestCounters::read();
+        TestCheckProfile::Sites sites;
+        TestCheckProfile::Sites* outerSites = TestCheckProfile::record(&sites);
+        mSoftFailures = 0;
+        long long startTime = TestClock::now();
+#ifdef __T_USE_SIGNAL_RECOVERY
+        TestSignals::Recovery recovery;
+        int signalNumber = sigsetjmp(recovery.point, 0);    // returns again with the number of the signal if the test crashes
+        if (signalNumber != 0) {
+            TestAllocations::restore(allocations);      // the destructors of the pauses in effect have not been called
+            result.addFailure(TestFailure(TestSignals::conditionOf(signalNumber), mName, "unknown file", -1));
+        } else
+#endif
+#ifndef DO_NOT_USE_EXCEPTIONS
+        try {
+            runTest(result);
+        } catch (std::exception& e) {
+            result.addFailure(TestFailure(TestCondition("Unhandled exception: ", e.what()), mName, "unknown file", -1));
+        } catch (...) {
+            result.addFailure(TestFailure(TestCondition("Unhandled exception: unknown"), mName, "unknown file", -1));
+        }
+#else
+        runTest(result);
+#endif
+        mDuration = TestClock::now() - startTime;
+        TestCheckProfile::record(outerSites);
+        counts = TestCounters::since(counts);
+        if (!isSuite() && TestAllocations::isTracked())
+            result.allocationResult(this, TestAllocations::statsSince(allocations));
+        if (!isSuite() && (mType != TestType::Benchmark) && counts.isCounted())
+            result.counterResult(this, TestCounters::statsOf(counts));  // the events of benchmarks are reported for their measured samples
+        for (TestCheckProfile::Sites::const_iterator it = sites.begin(); it != sites.end(); ++it)
+            result.checkResult(this, TestCheckProfile::statsOf(*it));
+#ifndef DO_NOT_USE_THREADS
+        if (watchdog != NULL)
+            watchdog->testEnds(this);
+#endif
+        result.testEnds(this);
+        mArena.reset();
+        
+        return (result.failures() - failuresBeforeTest);    // return the number of failures that occured during the test
+    }
+    
+    // counts a failed soft check, reporting that the test is stopped once the limit is exceeded.
+    inline bool Test::countSoftFailure(TestResult& result, const char* file, int line) {
+        if ((mMaxSoftFailures() == 0) || (++mSoftFailures <= mMaxSoftFailures()))
+            return true;
+        TestAllocations::Pause pause;   // reporting is not part of the test
+        TestCondition condition("Too many failed soft checks, the test is stopped");
+        result.addFailure(TestFailure(condition, mName, file, line));
+        return false;
+    }
+
+    // runs the specified child test, or commits its results if it has already been run by a worker thread or a child process.
+    inline void Test::dispatch(Test* test, TestResult& result) {
+        if (!TestFilter::accepts(test))
+            return;     // skipped before running anything, including fixtures setup
+        int failuresBeforeTest = result.failures();
+        runOrReplay(test, result);
+        
+        TestFilter* filter = TestFilter::active();
+        if ((filter != NULL) && !test->isSuite() && filter->testRan(test, result.failures() > failuresBeforeTest)) {
+            // fail fast, the remaining tests are skipped
+#ifdef __T_USE_PROCESSES
+            if (TestProcessPool::active() != NULL)
+                TestProcessPool::active()->cancel();
+#endif
+#ifndef DO_NOT_USE_THREADS
+            if (TestWorkerPool::active() != NULL)
+                TestWorkerPool::active()->cancel();
+#endif
+        }
+    }
+    
+    // runs the specified test, or commits its results if it has already been run by a worker thread or a child process.
+    inline void Test::runOrReplay(Test* test, TestResult& result) {
+#ifdef __T_USE_PROCESSES
+        TestProcessPool* processes = TestProcessPool::active();
+        if ((processes != NULL) && processes->replay(test, result))
+            return;
+#endif
+#ifndef DO_NOT_USE_THREADS
+        TestWorkerPool* pool = TestWorkerPool::active();
+        if (pool != NULL) {
+            if (pool->replay(test, result))
+                return;
+            if (!test->isSuite())
+                pool->waitIdle();   // serial test, make sure no other test is running
+        }
+#endif
+        test->run(result);
+    }
+    
+    // creates the tests of the registry and adds them to the global list, only once.
+    inline void Test::loadRegisteredTests() {
+        if (mLoaded())
+            return;
+        mLoaded() = true;
+        static TestTree tree(mTests(), false);  // keeps the suites only declared by their path
+    }
+    
+    // runs all the tests, using the specified TestResult object to process the test results.
+    inline int Test::runAll(TestResult& result, const TestOptions& options) {
+        loadRegisteredTests();
+#ifndef DO_NOT_USE_THREADS
+        std::unique_ptr<AsyncTestResult> asyncResult(options.asyncReport ? new AsyncTestResult(result) : NULL);
+        TestResult& report = options.asyncReport ? *asyncResult : result;
+        if (TestWatchdog::isNeeded(mTests(), options)) {
+            SynchronizedTestResult synchronizedResult(report);
+            TestWatchdog watchdog(synchronizedResult, options);
+            execute(synchronizedResult, options);
+            return result.failures();
+        }
+        execute(report, options);
+        return result.failures();
+#else
+        execute(result, options);
+        return result.failures();
+#endif
+    }
+    
+    // runs all the tests, reporting the results as specified in the options.
+    inline int Test::runAll(const TestOptions& options) {
+        std::ofstream file;
+        if (!options.outputFile.empty()) {
+            file.open(options.outputFile.c_str());
+            if (!file) {
+                std::cerr << "Can't write the report to " << options.outputFile << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        std::ostream& os = options.outputFile.empty() ? std::cout : file;
+        
+        if (options.report == TestOptions::JUnitXmlReport) {
+            JUnitXmlTestResult result(os);
+            return runAll(result, options);
+        } else if (options.report == TestOptions::JsonLinesReport) {
+            JsonLinesTestResult result(os);
+            return runAll(result, options);
+        }
+        OStreamTestResult result(os);
+        return runAll(result, options);
+    }
+    
+    // runs all the tests with the specified options.
+    inline void Test::execute(TestResult& result, const TestOptions& options) {
+        TestDurations durations;
+        if (!options.durationsFile.empty())
+            durations.load(options.durationsFile);
+        TestFailures failures;
+        if (!options.failuresFile.empty())
+            failures.load(options.failuresFile);
+        TestBaseline baseline(options.maxRegression);
+        if (!options.baselineFile.empty())
+            baseline.load(options.baselineFile);
+        TestFilter filter(mTests(), options, durations);
+        bool failedFirst = !failures.empty() && filter.prioritize(mTests(), failures);
+        if (failedFirst)
+            TestSuite::moveFirst(mTests(), filter.prioritized());   // a single ordered pass, so each suite is run once
+        TestFilter::active() = &filter;
+#ifndef DO_NOT_USE_THREADS
+        if (TestWatchdog::active() != NULL)
+            TestWatchdog::active()->record(&mTests(), &filter, &durations, &failures);  // saved if a test times out
+#endif
+        if (!options.baselineFile.empty() && !options.updateBaseline)
+            TestBaseline::active() = &baseline;
+        TestBenchmarkSamples reference(options.maxRegression);
+        bool compare = !options.compareFile.empty() && reference.load(options.compareFile);
+        if (compare)
+            TestBenchmarkSamples::active() = &reference;
+        else if (!options.compareFile.empty())
+            std::cerr << "Can't read the benchmarks to compare from " << options.compareFile << std::endl;
+        if (options.benchmarkWarnings && (!options.benchmarkFile.empty() || !options.compareFile.empty()))
+            TestBenchmarkSamples::warnAboutNoise(std::cerr);
+        TestCounters::setEnabled(options.counters);
+        TestCheckProfile::setEnabled(options.profileChecks);
+        TestSignals::install();
+        mMaxSoftFailures() = options.maxSoftFailures;
+        unsigned int seed = (options.shuffleSeed != 0) ? options.shuffleSeed : (unsigned int)(TestClock::now() % 1000000000 + 1);
+        if (options.shuffle)
+            std::cerr << "Shuffling the tests with seed " << seed << " (use --shuffle=" << seed << " to run them in the same order)" << std::endl;
+        std::mt19937 random(seed);
+        result.allTestsBegin();
+        for (unsigned int repetition = 0; ; ++repetition) {
+            int failuresBeforeRepetition = result.failures();
+            if (repetition != 0)
+                result.drain();     // the results of the previous repetition reference the tests run again
+            if (options.shuffle) {
+                TestSuite::shuffle(mTests(), random);   // after the shards are selected, so they do not depend on the order
+                if (failedFirst && (repetition == 0))
+                    TestSuite::moveFirst(mTests(), filter.prioritized());
+            }
+#ifdef __T_USE_PROCESSES
+            TestProcessPool processes(mTests(), options, durations);
+#endif
+#ifndef DO_NOT_USE_THREADS
+            TestWorkerPool pool(mTests(), options, durations);
+#endif
+            for (std::vector<Test*>::iterator it = mTests().begin(); it != mTests().end(); ++it)
+                dispatch(*it, result);
+            if (!options.repeatsAfter(repetition, result.failures() > failuresBeforeRepetition))
+                break;
+        }
+        TestSharedFixtures::global().release();
+        result.allTestsEnd();
+#ifndef DO_NOT_USE_THREADS
+        if (TestWatchdog::active() != NULL)
+            TestWatchdog::active()->record(NULL, NULL, NULL, NULL);
+#endif
+        TestFilter::active() = NULL;
+        TestBaseline::active() = NULL;
+        TestBenchmarkSamples::active() = NULL;
+        TestCounters::setEnabled(false);
+        TestCheckProfile::setEnabled(false);
+        
+        if (!options.durationsFile.empty()) {
+            durations.record(mTests(), filter);
+            durations.save(options.durationsFile);
+        }
+        if (!options.failuresFile.empty()) {
+            failures.record(mTests(), filter);
+            failures.save(options.failuresFile);
+        }
+        if (!options.baselineFile.empty() && options.updateBaseline) {
+            baseline.record(result.benchmarks());
+            baseline.save(options.baselineFile);
+        }
+        if (compare)
+            reference.print(std::cerr, result.benchmarks());
+        if (!options.benchmarkFile.empty() && !TestBenchmarkSamples().save(options.benchmarkFile, result.benchmarks()))
+            std::cerr << "Can't write the benchmarks to " << options.benchmarkFile << std::endl;
+    }
+    
+    // records the durations of the tests that have been run.
+    inline void TestDurations::record(const std::vector<Test*>& tests, const TestFilter& filter, const std::string& parentPath) {
+        for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+            if (!filter.isSelected(*it))
+                continue;
+            std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+            if ((*it)->isSuite())
+                record(static_cast<TestSuite*>(*it)->tests(), filter, path);
+            else if (filter.wasRun(*it))
+                set(path, (*it)->duration());
+        }
+    }
+    
+    // records the failures of the tests that have been run, tests that passed are removed.
+    inline void TestFailures::record(const std::vector<Test*>& tests, const TestFilter& filter, const std::string& parentPath) {
+        for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+            if (!filter.isSelected(*it))
+                continue;
+            std::string path = parentPath.empty() ? (*it)->name() : (parentPath + "/" + (*it)->name());
+            if ((*it)->isSuite())
+                record(static_cast<TestSuite*>(*it)->tests(), filter, path);
+            else if (filter.hasFailed(*it))
+                mPaths.insert(path);
+            else if (filter.wasRun(*it))
+                mPaths.erase(path);
+        }
+    }
+    
+    // records the medians of the benchmarks that have been run.
+    inline void TestBaseline::record(const std::vector<TestBenchmarkStats>& benchmarks) {
+        for (std::vector<TestBenchmarkStats>::const_iterator it = benchmarks.begin(); it != benchmarks.end(); ++it)
+            set(it->path(), it->median);
+    }
+    
+    // reports a failure if a benchmark is slower than its baseline by more than the allowed regression.
+    inline void TestBaseline::check(Test& test, const TestBenchmarkStats& stats, TestResult& result) const {
+        double reference = get(Test::pathOf(&test));
+        if ((reference <= 0.0) || (stats.median <= reference * (1.0 + mMaxRegression / 100.0)))
+            return;
+        std::ostringstream ss;
+        ss << "Benchmark median " << TestClock::format(stats.median) << "/op regressed by " << std::fixed << std::setprecision(1) 
+           << (100.0 * (stats.median - reference) / reference) << "% over the baseline " << TestClock::format(reference) << "/op (" 
+           << mMaxRegression << "% allowed)";
+        result.addFailure(TestFailure(ss.str(), test.name(), "unknown file", -1));
+    }
+    
+    // writes the samples and the statistics of the benchmarks that have been run, one JSON object per line.
+    inline bool TestBenchmarkSamples::save(const std::string& fileName, const std::vector<TestBenchmarkStats>& benchmarks) const {
+        std::ofstream file(fileName.c_str());
+        file << std::setprecision(12);
+        for (std::vector<TestBenchmarkStats>::const_iterator it = benchmarks.begin(); it != benchmarks.end(); ++it) {
+            std::string path = it->path();
+            file << "{\"path\":\"";
+            for (std::string::const_iterator c = path.begin(); c != path.end(); ++c)
+                file << (((*c == '"') || (*c == '\\')) ? "\\" : "") << *c;
+            file << "\",\"iterations\":" << it->iterations << ",\"samples\":" << it->samples << ",\"min_ns\":" << it->min << ",\"median_ns\":" 
+                 << it->median << ",\"p99_ns\":" << it->p99 << ",\"mean_ns\":" << it->mean << ",\"stddev_ns\":" << it->stddev << ",\"samples_ns\":[";
+            for (std::vector<double>::const_iterator sample = it->sampleTimes.begin(); sample != it->sampleTimes.end(); ++sample)
+                file << ((sample != it->sampleTimes.begin()) ? "," : "") << *sample;
+            file << "]}\n";
+        }
+        return (bool)file.flush();
+    }
+    
+    // reports a failure if a benchmark is significantly slower than the compared samples by more than the allowed regression.
+    inline void TestBenchmarkSamples::check(Test& test, const TestBenchmarkStats& stats, TestResult& result) const {
+        const std::vector<double>* reference = get(Test::pathOf(&test));
+        if (reference == NULL)
+            return;
+        TestBenchmarkDelta delta = TestBenchmarkDelta::between(stats.sampleTimes, *reference);
+        if (!isRegression(delta))
+            return;
+        std::ostringstream ss;
+        ss << "Benchmark regressed by " << std::fixed << std::setprecision(1) << (100.0 * (delta.ratio - 1.0)) << "% over the compared run ("
+           << (int)(100 * TestBenchmarkDelta::confidence()) << "% confidence interval " << (100.0 * (delta.lower - 1.0)) << "% to " 
+           << (100.0 * (delta.upper - 1.0)) << "%, p-value " << std::setprecision(4) << delta.pValue << ", " << mMaxRegression << "% allowed)";
+        result.addFailure(TestFailure(ss.str(), test.name(), "unknown file", -1));
+    }
+    
+    // prints the change of each benchmark compared to the samples, flagging the significant changes.
+    inline void TestBenchmarkSamples::print(std::ostream& os, const std::vector<TestBenchmarkStats>& benchmarks) const {
+        os << "Benchmarks compared to the previous run (" << (int)(100 * TestBenchmarkDelta::confidence()) << "% confidence intervals):" << std::endl;
+        for (std::vector<TestBenchmarkStats>::const_iterator it = benchmarks.begin(); it != benchmarks.end(); ++it) {
+            const std::vector<double>* reference = get(it->path());
+            if (reference == NULL) {
+                os << "  " << it->path() << ": new benchmark, median " << TestClock::format(it->median) << "/op" << std::endl;
+                continue;
+            }
+            TestBenchmarkDelta delta = TestBenchmarkDelta::between(it->sampleTimes, *reference);
+            std::ostringstream ss;  // formatted apart not to change the format of the stream
+            ss << std::showpos << std::fixed << std::setprecision(1) << (100.0 * (delta.ratio - 1.0)) << "% [" << (100.0 * (delta.lower - 1.0)) 
+               << "%, " << (100.0 * (delta.upper - 1.0)) << "%]" << std::noshowpos << ", p-value " << std::setprecision(4) << delta.pValue;
+            if (isRegression(delta))
+                ss << ", REGRESSION";
+            else if (delta.isSignificant())
+                ss << ((delta.ratio > 1.0) ? ", slower" : ", faster");
+            os << "  " << it->path() << ": " << ss.str() << std::endl;
+        }
+    }
+    
+    // prints the path of all the selected test cases.
+    inline int Test::listAll(std::ostream& os, const TestOptions& options) {
+        // the declared tests are listed from their descriptors unless they have already been created, only the parameterized tests are created
+        std::vector<Test*> tests(mTests());
+        std::vector<Test*> declaredTests;
+        std::unique_ptr<TestTree> placeholders(mLoaded() ? NULL : new TestTree(declaredTests, true));
+        tests.insert(tests.end(), declaredTests.begin(), declaredTests.end());
+        
+        TestDurations durations;
+        if (!options.durationsFile.empty())
+            durations.load(options.durationsFile);
+        TestFilter filter(tests, options, durations, (placeholders != NULL) ? &placeholders->declared() : NULL);
+        std::vector<std::pair<const Test*, std::string> > stack;
+        for (std::vector<Test*>::const_reverse_iterator it = tests.rbegin(); it != tests.rend(); ++it)
+            stack.push_back(std::make_pair(*it, (*it)->name()));
+        
+        while (!stack.empty()) {
+            const Test* test = stack.back().first;
+            std::string path = stack.back().second;
+            stack.pop_back();
+            if (!filter.isSelected(test))
+                continue;
+            if (!test->isSuite()) {
+                os << path << "\n";
+                continue;
+            }
+            const std::vector<Test*>& tests = static_cast<const TestSuite*>(test)->tests();
+            for (std::vector<Test*>::const_reverse_iterator it = tests.rbegin(); it != tests.rend(); ++it)
+                stack.push_back(std::make_pair(*it, path + "/" + (*it)->name()));
+        }
+        os.flush();
+        return 0;
+    }
+    
+    // gets the path of the specified test, the cases of the parameterized tests being found from their parent.
+    inline std::string Test::pathOf(const Test* test) {
+        loadRegisteredTests();
+        std::string path;
+        if (!findPath(mTests(), test, path) && (test->parent() != NULL))
+            path = pathOf(test->parent()) + "/" + test->name();
+        return path;
+    }
+    
+    // finds the path of a test in the specified test set.
+    inline bool Test::findPath(const std::vector<Test*>& tests, const Test* test, std::string& path) {
+        for (std::vector<Test*>::const_iterator it = tests.begin(); it != tests.end(); ++it) {
+            std::string testPath = path.empty() ? (*it)->name() : (path + "/" + (*it)->name());
+            if ((*it == test) || ((*it)->isSuite() && findPath(static_cast<TestSuite*>(*it)->tests(), test, testPath))) {
+                path = testPath;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+#pragma mark -
+#pragma mark Benchmarks
+    
+    /**
+     TestBenchmark measures the performance of a piece of code, by running it repeatedly in a loop controlled by the keepRunning() method.
+     The number of iterations per sample is first calibrated so that each sample lasts about the configured sample time, then some warmup samples are
+     run and discarded before the actual samples are measured. Once done the statistics are processed by TestResult::benchmarkResult(), and the hardware
+     events of the measured samples by TestResult::counterResult() if they are counted (see ntk::TestCounters).
+     
+     The BENCHMARK and BENCHMARK_LOOP macros are meant to simplify the declaration of benchmarks. As the code before the loop (for example a fixture 
+     declared with USE_FIXTURE) is not measured, setup costs are excluded from the results.
+     @see BENCHMARK
+     */
+    class TestBenchmark {
+    public:
+        
+        /** The benchmark settings. */
+        struct Settings {
+            
+            /** Creates the settings with default values. */
+            Settings() : sampleTime(5000000), samples(20), warmupSamples(2) {}
+            
+            long long sampleTime;   ///< The target duration of a sample in nanoseconds.
+            int samples;            ///< The number of measured samples.
+            int warmupSamples;      ///< The number of samples run before measuring.
+        };
+        
+        /** Creates a new benchmark for the specified test, that will process its statistics using the specified TestResult object. */
+        TestBenchmark(Test& test, TestResult& result, const Settings& settings = defaultSettings())
+        : mTest(test), mResult(result), mSettings(settings), mPhase(Calibration), mIterations(1), mRemaining(0), mSamplesLeft(0),
+          mStartTime(TestClock::now()), mCounting(TestCounters::isEnabled()), mCounts(0.0)
+        {}
+        
+        /** 
+         Returns true while the measured code must be run again. 
+         The fast path only decrements a counter, the clock being read once per sample.
+         */
+        bool keepRunning() {
+            if (mRemaining > 0) {
+                --mRemaining;
+                return true;
+            }
+            return nextSample();
+        }
+        
+        /** Gets the default benchmark settings, which can be modified to change the settings of all benchmarks. */
+        static Settings& defaultSettings() { static Settings settings; return settings; }
+        
+        /** Prevents the compiler from optimizing away the computation of the specified value. */
+        template <typename T>
+        static void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "r,m"(value) : "memory");
+#else
+            static volatile const void* sink;
+            sink = &value;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+        }
+        
+        /** Forces the compiler to assume that all memory has been read and written, so pending writes can't be optimized away. */
+        static void clobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : : "memory");
+#else
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+        }
+        
+    private:
+        enum Phase { Calibration, Warmup, Measure, Done };
+        
+        // processes the end of a sample, returns true if another sample must be run
+        bool nextSample() {
+            long long now = TestClock::now();
+            long long elapsed = now - mStartTime;
+            if (mCounting && (mPhase == Measure))
+                TestCounters::add(mCounts, TestCounters::since(mSampleCounts));
+            
+            switch (mPhase) {
+                case Calibration:
+                    if (elapsed < mSettings.sampleTime) {
+                        // grow the iterations count towards the target sample time, by a factor 10 at most
+                        double factor = (elapsed > 0) ? (1.2 * mSettings.sampleTime / elapsed) : 10.0;
+                        mIterations = std::max(mIterations + 1, (long long)(mIterations * std::min(10.0, factor)));
+                        break;
+                    }
+                    mPhase = Warmup;
+                    mSamplesLeft = mSettings.warmupSamples;
+                    // fall through
+                case Warmup:
+                    if (mSamplesLeft-- > 0)
+                        break;
+                    mPhase = Measure;
+                    mSamplesLeft = std::max(1, mSettings.samples);
+                    mSamples.reserve(mSamplesLeft);
+                    break;
+                case Measure:
+                    mSamples.push_back((double)elapsed / mIterations);
+                    if (--mSamplesLeft > 0)
+                        break;
+                    mPhase = Done;
+                    report();
+                    return false;
+                case Done:
+                    return false;
+            }
+            
+            mRemaining = mIterations - 1;   // this call accounts for the first iteration
+            if (mCounting && (mPhase == Measure))
+                mSampleCounts = TestCounters::read();   // read outside of the timed part of the sample
+            mStartTime = TestClock::now();
+            return true;
+        }
+        
+        // computes the statistics and sends them to the result
+        void report() {
+            TestAllocations::Pause pause;   // reporting is not part of the benchmark
+            std::sort(mSamples.begin(), mSamples.end());
+            size_t count = mSamples.size();
+            
+            TestBenchmarkStats stats;
+            stats.iterations = mIterations;
+            stats.samples = (int)count;
+            stats.min = mSamples.front();
+            stats.median = (count % 2) ? mSamples[count / 2] : ((mSamples[count / 2 - 1] + mSamples[count / 2]) / 2.0);
+            stats.p99 = mSamples[std::min(count - 1, (size_t)std::ceil(0.99 * count) - 1)];
+            
+            double sum = 0.0;
+            for (size_t i = 0; i < count; ++i)
+                sum += mSamples[i];
+            stats.mean = sum / count;
+            
+            double variance = 0.0;
+            for (size_t i = 0; i < count; ++i)
+                variance += (mSamples[i] - stats.mean) * (mSamples[i] - stats.mean);
+            stats.stddev = (count > 1) ? std::sqrt(variance / (count - 1)) : 0.0;
+            stats.sampleTimes = mSamples;
+            
+            mResult.benchmarkResult(&mTest, stats);
+            if (mCounting && mCounts.isCounted())
+                mResult.counterResult(&mTest, TestCounters::statsOf(mCounts, mIterations * (long long)count));
+            if (TestBaseline::active() != NULL)
+                TestBaseline::active()->check(mTest, stats, mResult);
+            if (TestBenchmarkSamples::active() != NULL)
+                TestBenchmarkSamples::active()->check(mTest, stats, mResult);
+        }
+        
+        Test& mTest;                    // the benchmark test
+        TestResult& mResult;            // the result processing the statistics
+        Settings mSettings;             // the benchmark settings
+        Phase mPhase;                   // the current phase
+        long long mIterations;          // the number of iterations per sample
+        long long mRemaining;           // the number of iterations left in the current sample
+        int mSamplesLeft;               // the number of samples left in the current phase
+        long long mStartTime;           // the start time of the current sample
+        std::vector<double> mSamples;   // the measured samples, in nanoseconds per iteration
+        bool mCounting;                 // true if the hardware events are counted
+        TestCounters::Counts mCounts;   // the hardware events counted during the measured samples
+        TestCounters::Counts mSampleCounts; // the hardware events counted when the current sample started
+        
+        // private copy constructor and assign operator as a benchmark can't be copied
+        TestBenchmark(const TestBenchmark&);
+        const TestBenchmark& operator=(const TestBenchmark&);
+    };
+    
+#pragma mark -
+#pragma mark Assertion templates
+    
+    /** Defines a set of assertion methods to do the test checks. */
+    namespace TestCheck {
+        
+        /** Expresses a failure of a test and gives details about it. */
+        inline void fail(const std::string& expression, const std::string& message,
+                  TestResult& result, const std::string& testName, const std::string& file, int line) 
+        {
+            std::string condition = expression;
+            if (!message.empty()) {
+                condition += ", Note: ";
+                condition += message;
+            }
+            result.addFailure(TestFailure(condition, testName, file, line));
+        }
+        
+        /** 
+         Expresses a failure of a test and gives details about it, without copying nor formatting anything until the failure is rendered.
+         An explanation message may be provided.
+         */
+        inline void fail(const TestCondition& condition, const char* message, TestResult& result, const char* testName, const char* file, int line) {
+            TestAllocations::Pause pause;   // reporting is not part of the test
+            TestCondition notedCondition(condition);
+            result.addFailure(TestFailure(notedCondition.note(message), testName, file, line));
+        }
+        
+        /** Same as above, with an explanation message given as a string. */
+        inline void fail(const TestCondition& condition, const std::string& message, 
+                         TestResult& result, const char* testName, const char* file, int line) {
+            fail(condition, message.c_str(), result, testName, file, line);
+        }
+        
+        /** Returns true if x and y are equal. */
+        template <typename X, typename Y>
+        bool equal(X x, Y y) {
+            return (x == y);
+        }
+                
+        /** Returns true if x and y of floating point type are equal. */
+        template <typename X, typename Y>
+        bool differ(X x, Y y) {
+            return !(x == y);
+        }
+        
+        /** Returns true if x and y are close by a maximum delta of d. */
+        template <typename X, typename Y, typename D>
+        bool close(X x, Y y, D d) {
+            return (((y - x) < d) && ((y - x) > -d));
+        }
+        
+        /** Returns true if x is less than y. */
+        template <typename X, typename Y>
+        bool less(X x, Y y) {
+            return (x < y);
+        }
+        
+        /** Returns true if x is less or equal than y. */
+        template <typename X, typename Y>
+        bool lessOrEqual(X x, Y y) {
+            return (x <= y);
+        }
+        
+        /** Returns true if x is more than y. */
+        template <typename X, typename Y>
+        bool more(X x, Y y) {
+            return (x > y);
+        }
+        
+        /** Returns true if x is more or equal than y. */
+        template <typename X, typename Y>
+        bool moreOrEqual(X x, Y y) {
+            return (x >= y);
+        }
+        
+        /** Returns true if the data of the specified size at position x and y is the same.*/
+        inline bool sameData(const void* x, const void* y, size_t size) {
+            if (size == 0)
+                return true;
+            
+            if (x == y)
+                return true;
+            
+            if ((x == NULL) || (y == NULL))
+                return false;
+            
+            return (std::memcmp(x, y, size) == 0);  // vectorized by the standard library
+        }
+        
+        /**
+         Describes how the data of the specified size at position x and y differs: the offset of the first differing byte and the number of differing 
+         bytes, which are computed a word at a time. The data is only referenced, to print a bounded window of bytes around the first difference.
+         */
+        class DataDifference {
+        public:
+            
+            /** Compares the data of the specified size at position x and y. */
+            DataDifference(const void* x, const void* y, size_t size)
+            : mX((const unsigned char*)x), mY((const unsigned char*)y), mSize(size), mOffset(0), mCount(0)
+            {
+                if ((size == 0) || (x == y))
+                    return;
+                if ((x == NULL) || (y == NULL)) {
+                    mCount = size;
+                    return;
+                }
+                
+                bool found = false;
+                size_t i = 0;
+                for (; i + sizeof(unsigned long long) <= size; i += sizeof(unsigned long long)) {
+                    unsigned long long wx, wy;
+                    std::memcpy(&wx, mX + i, sizeof(wx));   // unaligned loads
+                    std::memcpy(&wy, mY + i, sizeof(wy));
+                    if (wx == wy)
+                        continue;
+                    if (!found) {
+                        for (mOffset = i; mX[mOffset] == mY[mOffset]; ++mOffset) {}
+                        found = true;
+                    }
+                    mCount += differingBytes(wx ^ wy);
+                }
+                for (; i < size; ++i) {
+                    if (mX[i] == mY[i])
+                        continue;
+                    if (!found) {
+                        mOffset = i;
+                        found = true;
+                    }
+                    ++mCount;
+                }
+            }
+            
+            /** Gets the offset of the first differing byte. */
+            size_t offset() const { return mOffset; }
+            
+            /** Gets the number of differing bytes. */
+            size_t count() const { return mCount; }
+            
+            /** Stream output operator, prints the number of differing bytes and the bytes of both data around the first difference. */
+            friend std::ostream& operator<<(std::ostream& os, const DataDifference& difference) {
+                if (difference.mCount == 0)
+                    return os;
+                os << ", " << difference.mCount << " bytes differ from offset " << difference.mOffset;
+                if ((difference.mX == NULL) || (difference.mY == NULL))
+                    return (os << " (NULL data)");
+                
+                size_t begin = difference.mOffset - (difference.mOffset % WindowSize);
+                size_t end = std::min(difference.mSize, begin + WindowSize);
+                os << " (bytes " << begin << " to " << (end - 1) << ":";
+                printBytes(os, difference.mX + begin, end - begin);
+                os << " !=";
+                printBytes(os, difference.mY + begin, end - begin);
+                return (os << ")");
+            }
+            
+        private:
+            static const size_t WindowSize = 16;    // the number of bytes printed around the first difference
+            
+            // returns the number of non zero bytes in a word
+            static size_t differingBytes(unsigned long long word) {
+                const unsigned long long low = ~0ull / 0xff * 0x7f;   // 0x7f7f...
+                word = (((word & low) + low) | word) & ~low;        // keeps the high bit of each non zero byte
+                size_t count = 0;
+                for (; word != 0; word &= word - 1)
+                    ++count;
+                return count;
+            }
+            
+            // prints bytes in hexadecimal
+            static void printBytes(std::ostream& os, const unsigned char* bytes, size_t size) {
+                static const char digits[] = "0123456789abcdef";
+                for (size_t i = 0; i < size; ++i)
+                    os << ' ' << digits[bytes[i] >> 4] << digits[bytes[i] & 0xf];
+            }
+            
+            const unsigned char* mX;    // the first data
+            const unsigned char* mY;    // the second data
+            size_t mSize;               // the size of the data
+            size_t mOffset;             // the offset of the first differing byte
+            size_t mCount;              // the number of differing bytes
+        };
+        
+        /**
+         Compares 2 ranges of values element by element (containers or arrays), and describes their difference: the number of mismatching elements,
+         the indices of the first ones and for arithmetic values, the maximum absolute and relative errors. Mismatches are counted in a first tight 
+         pass, the details being only gathered if any element mismatches.
+         */
+        class RangeDifference {
+        public:
+            
+            /** The maximum number of mismatching indices reported. */
+            static const size_t MaxIndices = 8;
+            
+            /** Creates an empty difference. */
+            RangeDifference() 
+            : mSizeX(0), mSizeY(0), mCount(0), mIndexCount(0), mMeasured(false), mMaxAbsoluteError(0.0), mMaxRelativeError(0.0) 
+            {}
+            
+            /** Compares the elements of the x and y ranges using ntk::TestCheck::equal(), returns true if they are all equal. */
+            template <typename X, typename Y>
+            bool compareEqual(const X& x, const Y& y) {
+                return compare(std::begin(x), std::end(x), std::begin(y), std::end(y), Equal());
+            }
+            
+            /** Compares the elements of the x and y ranges using ntk::TestCheck::close(), returns true if they are all close by a maximum delta of d. */
+            template <typename X, typename Y, typename D>
+            bool compareClose(const X& x, const Y& y, const D& d) {
+                return compare(std::begin(x), std::end(x), std::begin(y), std::end(y), Close<D>(d));
+            }
+            
+            /** Gets the number of mismatching elements. */
+            size_t count() const { return mCount; }
+            
+            /** Gets the index of the specified mismatching element, from 0 to min(count(), MaxIndices) - 1. */
+            size_t index(size_t i) const { return mIndices[i]; }
+            
+            /** Gets the maximum absolute error between arithmetic elements, 0 if the elements are not arithmetic. */
+            double maxAbsoluteError() const { return mMaxAbsoluteError; }
+            
+            /** Gets the maximum relative error between arithmetic elements, 0 if the elements are not arithmetic. */
+            double maxRelativeError() const { return mMaxRelativeError; }
+            
+            /** Stream output operator, prints the sizes if they differ, or the number and indices of the mismatching elements and the errors. */
+            friend std::ostream& operator<<(std::ostream& os, const RangeDifference& difference) {
+                if (difference.mSizeX != difference.mSizeY)
+                    return (os << ", sizes differ (" << difference.mSizeX << " != " << difference.mSizeY << ")");
+                if (difference.mCount == 0)
+                    return os;
+                
+                os << ", " << difference.mCount << " of " << difference.mSizeX << " elements differ at indices ";
+                for (size_t i = 0; i < difference.mIndexCount; ++i)
+                    os << ((i != 0) ? ", " : "") << difference.mIndices[i];
+                if (difference.mCount > difference.mIndexCount)
+                    os << ", ...";
+                if (difference.mMeasured)
+                    os << " (max absolute error " << difference.mMaxAbsoluteError << ", max relative error " << difference.mMaxRelativeError << ")";
+                return os;
+            }
+            
+        private:
+            // compares elements with ntk::TestCheck::equal()
+            struct Equal {
+                template <typename X, typename Y>
+                bool operator()(const X& x, const Y& y) const { return equal(x, y); }
+            };
+            
+            // compares elements with ntk::TestCheck::close()
+            template <typename D>
+            struct Close {
+                Close(const D& theDelta) : delta(theDelta) {}
+                template <typename X, typename Y>
+                bool operator()(const X& x, const Y& y) const { return close(x, y, delta); }
+                D delta;
+            };
+            
+            // compares the ranges
+            template <typename IX, typename IY, typename Predicate>
+            bool compare(IX x, IX xEnd, IY y, IY yEnd, Predicate predicate) {
+                mSizeX = (size_t)std::distance(x, xEnd);
+                mSizeY = (size_t)std::distance(y, yEnd);
+                if (mSizeX != mSizeY)
+                    return false;
+                
+                IX ix = x;
+                IY iy = y;
+                for (; ix != xEnd; ++ix, ++iy)
+                    mCount += !predicate(*ix, *iy);
+                if (mCount == 0)
+                    return true;
+                
+                // details, only needed on failure
+                for (size_t i = 0; x != xEnd; ++x, ++y, ++i) {
+                    if ((mIndexCount < MaxIndices) && !predicate(*x, *y))
+                        mIndices[mIndexCount++] = i;
+                    measure(*x, *y, std::integral_constant<bool, std::is_arithmetic<typename std::iterator_traits<IX>::value_type>::value 
+                                                                 && std::is_arithmetic<typename std::iterator_traits<IY>::value_type>::value>());
+                }
+                return false;
+            }
+            
+            // measures the errors between arithmetic elements
+            template <typename X, typename Y>
+            void measure(const X& x, const Y& y, std::true_type) {
+                double absoluteError = std::fabs((double)x - (double)y);
+                double magnitude = std::max(std::fabs((double)x), std::fabs((double)y));
+                mMaxAbsoluteError = std::max(mMaxAbsoluteError, absoluteError);
+                if (magnitude != 0.0)
+                    mMaxRelativeError = std::max(mMaxRelativeError, absoluteError / magnitude);
+                mMeasured = true;
+            }
+            
+            // errors are not defined for other elements
+            template <typename X, typename Y>
+            void measure(const X&, const Y&, std::false_type) {}
+            
+            size_t mSizeX;                  // the number of elements of the x range
+            size_t mSizeY;                  // the number of elements of the y range
+            size_t mCount;                  // the number of mismatching elements
+            size_t mIndices[MaxIndices];    // the indices of the first mismatching elements
+            size_t mIndexCount;             // the number of recorded indices
+            bool mMeasured;                 // true if the errors have been measured
+            double mMaxAbsoluteError;       // the maximum absolute error
+            double mMaxRelativeError;       // the maximum relative error
+        };
+        
+        /** Returns a string corresponding to the specified value. */
+        template <typename T>
+        std::string stringValue(const T& value) {
+            std::ostringstream ss;
+            ss << value;
+            return ss.str();
+        }
+        
+        /**
+         The estimated median of timing samples, with a distribution free confidence interval computed from the order statistics of the samples, 
+         so that a check only fails when the measures are significant and not because of a single slow sample.
+         */
+        struct TimingEstimate {
+            
+            /** Creates an empty estimate, of durations (or of ratios of durations if ratio is true). */
+            TimingEstimate(bool isRatio = false) : median(0), lower(0), upper(0), samples(0), ratio(isRatio) {}
+            
+            double median;  ///< The median of the samples.
+            double lower;   ///< The lower bound of the confidence interval of the median.
+            double upper;   ///< The upper bound of the confidence interval of the median.
+            int samples;    ///< The number of samples.
+            bool ratio;     ///< True if the samples are ratios of durations, durations in nanoseconds per iteration otherwise.
+            
+            /** The confidence level of the interval. */
+            static double confidence() { return 0.95; }
+            
+            /** The number of samples measured by the timing checks. */
+            enum { Samples = 21 };
+            
+            /** The minimum duration of a sample in nanoseconds, the measured code being repeated as needed. */
+            enum { MinSampleTime = 1000000 };
+        };
+        
+        /** Prints the specified timing estimate, as the description of a timing check failure. */
+        inline std::ostream& operator<<(std::ostream& os, const TimingEstimate& estimate) {
+            if (estimate.ratio) {
+                os << std::fixed << std::setprecision(2) << ", median speedup " << estimate.median << "x (" << (int)(100 * TimingEstimate::confidence()) 
+                   << "% confidence interval " << estimate.lower << "x to " << estimate.upper << "x";
+            } else {
+                os << ", median " << TestClock::format(estimate.median) << " (" << (int)(100 * TimingEstimate::confidence()) << "% confidence interval " 
+                   << TestClock::format(estimate.lower) << " to " << TestClock::format(estimate.upper);
+            }
+            return os << ", " << estimate.samples << " samples)";
+        }
+        
+        /** Estimates the median of the specified samples and its confidence interval, sorting the samples. */
+        inline void estimateMedian(std::vector<double>& samples, TimingEstimate& estimate) {
+            std::sort(samples.begin(), samples.end());
+            size_t count = samples.size();
+            estimate.samples = (int)count;
+            if (count == 0)
+                return;
+            estimate.median = (count % 2) ? samples[count / 2] : ((samples[count / 2 - 1] + samples[count / 2]) / 2.0);
+            
+            // the interval [x(k), x(n-k+1)] contains the median with a probability of 1 - 2 P(B < k), with B following the binomial law B(n, 0.5)
+            size_t k = 1;
+            double probability = std::pow(0.5, (double)count);  // P(B = 0)
+            double cumulated = probability;                     // P(B < k + 1)
+            while ((k < count / 2) && (2 * cumulated <= 1.0 - TimingEstimate::confidence())) {
+                probability *= (double)(count - k + 1) / k;     // P(B = k)
+                if (2 * (cumulated + probability) > 1.0 - TimingEstimate::confidence())
+                    break;
+                cumulated += probability;
+                ++k;
+            }
+            estimate.lower = samples[k - 1];
+            estimate.upper = samples[count - k];
+        }
+        
+        /** Gets the number of iterations of the specified function needed for a sample to last at least the minimum sample time. */
+        template <typename F>
+        long long calibrateIterations(F& function) {
+            for (long long iterations = 1; ; iterations *= 2) {
+                long long start = TestClock::now();
+                for (long long i = 0; i < iterations; ++i)
+                    function();
+                if ((TestClock::now() - start >= TimingEstimate::MinSampleTime) || (iterations >= (1ll << 40)))
+                    return iterations;
+            }
+        }
+        
+        /** Measures the time in nanoseconds per iteration of the specified function, running it the specified number of times. */
+        template <typename F>
+        double measureIterations(F& function, long long iterations) {
+            long long start = TestClock::now();
+            for (long long i = 0; i < iterations; ++i)
+                function();
+            return (double)(TestClock::now() - start) / iterations;
+        }
+        
+        /** Estimates the median duration in nanoseconds of the specified function, from repeated samples. */
+        template <typename F>
+        TimingEstimate sampleDuration(F function) {
+            long long iterations = calibrateIterations(function);
+            std::vector<double> samples;
+            for (int i = 0; i < TimingEstimate::Samples; ++i)
+                samples.push_back(measureIterations(function, iterations));
+            TimingEstimate estimate;
+            estimateMedian(samples, estimate);
+            return estimate;
+        }
+        
+        /** 
+         Estimates the median speedup of the function a over the function b, i.e. the ratio of the duration of b over the duration of a. 
+         Both functions are sampled alternately, so that a change of the machine load affects both measures.
+         */
+        template <typename F, typename G>
+        TimingEstimate sampleSpeedup(F a, G b) {
+            long long aIterations = calibrateIterations(a);
+            long long bIterations = calibrateIterations(b);
+            std::vector<double> samples;
+            for (int i = 0; i < TimingEstimate::Samples; ++i) {
+                double aDuration = measureIterations(a, aIterations);
+                double bDuration = measureIterations(b, bIterations);
+                samples.push_back(bDuration / std::max(aDuration, 1e-3));
+            }
+            TimingEstimate estimate(true);
+            estimateMedian(samples, estimate);
+            return estimate;
+        }
+        
+    }
     
 #pragma mark -
 #pragma mark Internal helper macros
     
 #   define __T_FAIL(condition, message)    ntk::TestCheck::fail(condition, message, result, name(), __FILE__, __LINE__)
-#   define __T_VAL(value)                  ntk::TestCheck::stringValue(value)
     
-#   define __T_CHECK2(testFunction, operandString, x, y, message) \
-    if (!ntk::TestCheck::testFunction(x, y)) { \
-        __T_FAIL(#x " (" + __T_VAL(x) + ") " + std::string(operandString) + " " #y " (" + __T_VAL(y) + ")", message); \
+#   define __T_MULTILINE_BEGIN  do {
+#   define __T_MULTILINE_END    } while(0)
+    
+    // a failed assertion stops the test
+#   define __T_ASSERT_FAILURE(condition, message) \
+    __T_MULTILINE_BEGIN \
+    __T_FAIL(condition, message); \
+    return; \
+    __T_MULTILINE_END
+    
+    // a failed soft check is reported and the test goes on, unless the test has reached the limit of failed soft checks
+#   define __T_SOFT_FAILURE(condition, message) \
+    __T_MULTILINE_BEGIN \
+    if (!countSoftFailure(result, __FILE__, __LINE__)) \
         return; \
+    __T_FAIL(condition, message); \
+    __T_MULTILINE_END
+    
+    // measures the check from this point to the end of its scope, if checks are profiled
+#   define __T_PROFILE_CHECK    ntk::TestCheckProfile::Scope __t_profile(__FILE__, __LINE__);
+    
+    // the checks below report their failures with the specified failure macro, __T_ASSERT_FAILURE or __T_SOFT_FAILURE
+#   define __T_CHECK(failure, predicate, message) \
+    { \
+        __T_PROFILE_CHECK \
+        if (!(predicate)) \
+            failure(#predicate, message); \
     }
     
-#   define __T_CHECK3(testFunction, operandString1, operandString2, x, y, z, message) \
-    if (!ntk::TestCheck::testFunction(x, y, z)) { \
-        __T_FAIL(#x " (" + __T_VAL(x) + ") " + std::string(operandString1) + " " #y " (" + __T_VAL(y) + ") " \
-                 + std::string(operandString2) + " " #z " (" + __T_VAL(z) + ")", message); \
-        return; \
+    // the operands are evaluated once, and only formatted if the failure is rendered
+#   define __T_CHECK2(failure, testFunction, operandString, x, y, message) \
+    { \
+        __T_PROFILE_CHECK \
+        const auto& __t_x = (x); \
+        const auto& __t_y = (y); \
+        if (!ntk::TestCheck::testFunction(__t_x, __t_y)) \
+            failure(ntk::TestCondition(#x, __t_x, operandString, #y, __t_y), message); \
     }
     
-#   define __T_CHECK3_NOPRINT(testFunction, operandString1, operandString2, x, y, z, message) \
-    if (!ntk::TestCheck::testFunction(x, y, z)) { \
-        __T_FAIL(#x " " + std::string(operandString1) + " " #y " " + std::string(operandString2) + " " + #z, message); \
-        return; \
+#   define __T_CHECK3(failure, testFunction, operandString1, operandString2, x, y, z, message) \
+    { \
+        __T_PROFILE_CHECK \
+        const auto& __t_x = (x); \
+        const auto& __t_y = (y); \
+        const auto& __t_z = (z); \
+        if (!ntk::TestCheck::testFunction(__t_x, __t_y, __t_z)) \
+            failure(ntk::TestCondition(#x, __t_x, operandString1, #y, __t_y, operandString2, #z, __t_z), message); \
     }
     
-#   define __T_MULTILINE_BEGIN  do {
-#   define __T_MULTILINE_END    } while(0)
+    // the ranges are compared in a single check
+#   define __T_CHECK_RANGE(failure, comparison, conditionString, message) \
+    { \
+        __T_PROFILE_CHECK \
+        ntk::TestCheck::RangeDifference __t_difference; \
+        if (!__t_difference.comparison) \
+            failure(ntk::TestCondition(conditionString).describe(__t_difference), message); \
+    }
+    
+    // the data is only scanned for the differences if the check fails
+#   define __T_CHECK_DATA(failure, x, y, s, message) \
+    { \
+        __T_PROFILE_CHECK \
+        const void* __t_x = (x); \
+        const void* __t_y = (y); \
+        size_t __t_s = (s); \
+        if (!ntk::TestCheck::sameData(__t_x, __t_y, __t_s)) { \
+            ntk::TestCheck::DataDifference __t_difference(__t_x, __t_y, __t_s); \
+            failure(ntk::TestCondition(#x " has same data as " #y " with size " #s).describe(__t_difference), message); \
+        } \
+    }
+    
+    // the allocations are checked when the block of code that follows the check ends, the check being profiled but not the block
+#   define __T_CHECK_ALLOCS(failure, maxAllocations, message) \
+    for (ntk::TestAllocations::Scope __t_allocations(maxAllocations); ; __t_allocations.end()) \
+        if (__t_allocations.hasEnded()) { \
+            __T_PROFILE_CHECK \
+            if (!ntk::TestAllocations::isTracked()) \
+                failure(ntk::TestCondition("Allocations are not tracked, TRACK_ALLOCATIONS must be used"), message); \
+            else if (__t_allocations.allocations() > __t_allocations.limit()) \
+                failure(ntk::TestCondition("allocations", __t_allocations.allocations(), "<=", #maxAllocations, \
+                                           __t_allocations.limit()), message); \
+            break; \
+        } else
+    
+#   define __T_CHECK_DURATION(failure, expression, budget, message) \
+    { \
+        __T_PROFILE_CHECK \
+        ntk::TestCheck::TimingEstimate __t_estimate = ntk::TestCheck::sampleDuration([&]() { expression; }); \
+        if (__t_estimate.lower > ntk::TestClock::nanoseconds(budget)) \
+            failure(ntk::TestCondition("duration of " #expression " below " #budget).describe(__t_estimate), message); \
+    }
+    
+#   define __T_CHECK_SPEEDUP(failure, a, b, ratio, message) \
+    { \
+        __T_PROFILE_CHECK \
+        ntk::TestCheck::TimingEstimate __t_estimate = ntk::TestCheck::sampleSpeedup([&]() { a; }, [&]() { b; }); \
+        if (__t_estimate.upper < (ratio)) \
+            failure(ntk::TestCondition(#a " faster than " #b " by a factor of " #ratio).describe(__t_estimate), message); \
+    }
+    
+#   define __T_CHECK_THROWS(failure, method, exception, message) \
+    { \
+        __T_PROFILE_CHECK \
+        try { \
+            method; \
+            failure(#method " throws exception " #exception, message); \
+        } catch(exception) {} \
+    }
+    
+#   define __T_CHECK_THROWS_ANY(failure, method, message) \
+    __T_MULTILINE_BEGIN \
+    __T_PROFILE_CHECK \
+    try { \
+        method; \
+        failure(#method " throws any exception", message); \
+    } catch(...) {} \
+    __T_MULTILINE_END
+    
+#   define __T_CHECK_NOTHROW(failure, method, message) \
+    __T_MULTILINE_BEGIN \
+    __T_PROFILE_CHECK \
+    try { \
+        method; \
+    } catch(...) { \
+        failure(#method " does not throw exception", message); \
+    } \
+    __T_MULTILINE_END
     
 #ifndef DO_NOT_USE_EXCEPTIONS
     
@@ -644,7 +6545,7 @@ namespace ntk {
     try {
 #   define __E_CATCH \
     } catch (std::exception& e) { \
-        __T_FAIL("Unhandled exception: " + std::string(e.what()), ""); \
+        __T_FAIL(ntk::TestCondition("Unhandled exception: ", e.what()), ""); \
         return ; \
     } catch (...) { \
         __T_FAIL("Unhandled exception: unknown", ""); \
@@ -659,6 +6560,54 @@ namespace ntk {
     
 #endif // DO_NOT_USE_EXCEPTIONS
     
+#pragma mark -
+#pragma mark Test registration macros
+    
+#ifdef __COUNTER__
+#   define __T_ORDER __COUNTER__
+#else
+#   define __T_ORDER 0
+#endif
+    
+#   define __T_CONCAT_(x, y) x##y
+#   define __T_CONCAT(x, y) __T_CONCAT_(x, y)
+    
+    // declares a constant test descriptor named after the identifier and adds it to the registry, the test is only created when the tests are loaded
+#   define __T_DESCRIPTOR(identifier, testKind, testName, testInstance, parentInstance) \
+    static const ntk::TestDescriptor identifier##_Descriptor = \
+        { ntk::TestDescriptor::testKind, testName, __FILE__, __LINE__, __T_ORDER, testInstance, parentInstance }
+    
+#ifdef __T_USE_TEST_SECTION
+#   define __T_REGISTER(identifier, testKind, testName, testInstance, parentInstance) \
+    __T_DESCRIPTOR(identifier, testKind, testName, testInstance, parentInstance); \
+    static const ntk::TestDescriptor* const identifier##_Registration __attribute__((used, section("ntk_test_registry"))) = &identifier##_Descriptor
+#else
+#   define __T_REGISTER(identifier, testKind, testName, testInstance, parentInstance) \
+    __T_DESCRIPTOR(identifier, testKind, testName, testInstance, parentInstance); \
+    static const ntk::TestRegistry::Registrar identifier##_Registration(identifier##_Descriptor)
+#endif
+    
+    // declares the function creating the test on first use
+#   define __T_INSTANCE(className) \
+    static ntk::Test& instance() { static className test; return test; }
+    
+    // declares a parameterized test running its cases from the specified source, followed by the test code
+#   define __T_PARAMETERIZED(testName, sourceType, source) \
+    class testName##_Case : public ntk::TestParameterCase<sourceType::Parameter> { \
+    public: \
+        testName##_Case(const std::string& name, const Parameter& parameter) : ntk::TestParameterCase<Parameter>(name, parameter) {} \
+    protected: \
+        void testImplementation(ntk::TestResult& result); \
+        virtual void runTest(ntk::TestResult& result) { __E_TRY testImplementation(result); __E_CATCH; } \
+    }; \
+    class testName##_Test : public ntk::TestParameterized<testName##_Case, sourceType> { \
+    public: \
+        testName##_Test() : ntk::TestParameterized<testName##_Case, sourceType>(ntk::Test::StaticName(#testName), sourceType(source), __FILE__, __LINE__) {} \
+        __T_INSTANCE(testName##_Test) \
+    }; \
+    __T_REGISTER(testName##_Test, ParameterizedTest, #testName, &testName##_Test::instance, NULL); \
+    void testName##_Case::testImplementation(ntk::TestResult& result)
+    
 #pragma mark -
 #pragma mark Test helper macros
     
@@ -674,13 +6623,102 @@ namespace ntk {
 #   define TEST(testName) \
     class testName##_Test : public ntk::Test { \
     public: \
-        testName##_Test() : ntk::Test(#testName) { ntk::TestSuite::currentTestSuite(NULL)->addTest(this); } \
+        testName##_Test() : ntk::Test(ntk::Test::StaticName(#testName)) {} \
+        __T_INSTANCE(testName##_Test) \
+    protected: \
+        void testImplementation(ntk::TestResult& result); \
+        virtual void runTest(ntk::TestResult& result) { __E_TRY testImplementation(result); __E_CATCH; } \
+    }; \
+    __T_REGISTER(testName##_Test, TestCase, #testName, &testName##_Test::instance, NULL); \
+    void testName##_Test::testImplementation(ntk::TestResult& result)
+    
+    /**
+     Helper macro for creating a test that fails if it runs for more than the specified time in milliseconds.
+     If tests are isolated in child processes the test is aborted, otherwise the run is stopped after reporting the failure.
+     Usage example:
+     @code
+     TEST_TIMEOUT(MyTestName, 500) {
+         // test code goes here, must complete in less than 500 ms
+     }
+     @endcode
+     */
+#   define TEST_TIMEOUT(testName, timeoutMilliseconds) \
+    class testName##_Test : public ntk::Test { \
+    public: \
+        testName##_Test() : ntk::Test(ntk::Test::StaticName(#testName)) {} \
+        __T_INSTANCE(testName##_Test) \
+        virtual unsigned int timeout() const { return (timeoutMilliseconds); } \
     protected: \
         void testImplementation(ntk::TestResult& result); \
-        virtual void runTest(ntk::TestResult& result) { SETUP_EXCEPTIONS(); __E_TRY testImplementation(result); __E_CATCH; } \
-    } testName##_Test_Instance; \
+        virtual void runTest(ntk::TestResult& result) { __E_TRY testImplementation(result); __E_CATCH; } \
+    }; \
+    __T_REGISTER(testName##_Test, TestCase, #testName, &testName##_Test::instance, NULL); \
     void testName##_Test::testImplementation(ntk::TestResult& result)
     
+    /**
+     Helper macro for creating a parameterized test, running the test code once per value of a generator (any container with size() and operator[],
+     such as a std::vector or a ntk::TestRange), evaluated when the tests are first listed or run. Each value is a separate case, named after its
+     index and reported as a test case, the value being available as "param". The cases are run in batches (see ntk::TestParameterized).
+     Usage example:
+     @code
+     TEST_P(MyParameterizedTest, ntk::TestRange<int>(0, 1000)) {
+         T_CHECK_EQUAL(decode(encode(param)), param);   // run for each integer from 0 to 999
+     }
+     @endcode
+     */
+#   define TEST_P(testName, generator) \
+    typedef ntk::TestValues<std::decay<decltype(generator)>::type> testName##_Source; \
+    __T_PARAMETERIZED(testName, testName##_Source, generator)
+    
+    /**
+     Helper macro for creating a data driven test, running the test code once per line of a file, the path of the file being relative to the working
+     directory. Each line is a separate case, named after its offset in the file and reported as a test case, the line being available as "param"
+     (see ntk::TestData). The file is streamed in batches of cases, and never loaded whole (see ntk::TestDataFile).
+     Usage example:
+     @code
+     TEST_DATA(MyDataTest, "golden/cases.txt") {
+         T_CHECK(parse(param.str()));   // run for each line of the file
+     }
+     @endcode
+     */
+#   define TEST_DATA(testName, fileName) \
+    __T_PARAMETERIZED(testName, ntk::TestDataFile, fileName)
+    
+    /**
+     Helper macro for creating a benchmark, i.e. a test measuring the performance of the code inside a BENCHMARK_LOOP.
+     Benchmarks are run serially, never concurrently with other tests, to avoid skewing the measures. Assertions can be used as in any other test.
+     Usage example:
+     @code
+     BENCHMARK(MyBenchmark) {
+         USE_FIXTURE(MyFixture);    // setup code is not measured
+         BENCHMARK_LOOP {
+             // measured code goes here
+             ntk::TestBenchmark::doNotOptimize(F.myVar * 2);
+         }
+     }
+     @endcode
+     */
+#   define BENCHMARK(benchmarkName) \
+    class benchmarkName##_Test : public ntk::Test { \
+    public: \
+        benchmarkName##_Test() : ntk::Test(ntk::Test::StaticName(#benchmarkName), ntk::TestType::Benchmark) {} \
+        __T_INSTANCE(benchmarkName##_Test) \
+        virtual bool isSerial() const { return true; } \
+    protected: \
+        void testImplementation(ntk::TestResult& result); \
+        virtual void runTest(ntk::TestResult& result) { __E_TRY testImplementation(result); __E_CATCH; } \
+    }; \
+    __T_REGISTER(benchmarkName##_Test, TestCase, #benchmarkName, &benchmarkName##_Test::instance, NULL); \
+    void benchmarkName##_Test::testImplementation(ntk::TestResult& result)
+    
+    /**
+     Helper macro running the code that follows repeatedly to measure its performance, must be used inside a BENCHMARK.
+     @see BENCHMARK
+     @see ntk::TestBenchmark
+     */
+#   define BENCHMARK_LOOP \
+    for (ntk::TestBenchmark __benchmark(*this, result); __benchmark.keepRunning(); )
+    
     /**
      Helper macro for creating a test fixture.
      Usage example:
@@ -727,6 +6765,29 @@ namespace ntk {
      */
 #   define TEARDOWN(fixtureName) \
     ~fixtureName##_TestFixture()
+    
+    /**
+     Helper macro for declaring fixture reset method (optional).
+     A fixture declaring a reset method is pooled: once a test using it completes, the fixture is kept to be used by the next test run on the same 
+     thread, which calls the reset method instead of destroying the fixture and setting up a new one. The reset method must then restore the state
+     set by the setup method. The teardown method is only called when the thread exits.
+     Usage example:
+     @code
+     FIXTURE(MyFixture) {
+         std::vector<char> buffer;
+         
+         SETUP(MyFixture) : buffer(100000000) {}    // allocated once per thread
+         
+         RESET(MyFixture) {
+             std::fill(buffer.begin(), buffer.end(), 0);
+         }
+     };
+     @endcode
+     @see FIXTURE
+     */
+#   define RESET(fixtureName) \
+    typedef void PooledTestFixture; \
+    void resetTestFixture()
 
     /**
      Helper macro to use a previously defined fixture in a test.
@@ -734,7 +6795,40 @@ namespace ntk {
      @see FIXTURE
      */
 #   define USE_FIXTURE(fixtureName) \
-    fixtureName##_TestFixture F;
+    ntk::TestFixtureInstance<fixtureName##_TestFixture> __t_fixture; \
+    fixtureName##_TestFixture& F = __t_fixture.get(); \
+    (void)F;
+    
+    /**
+     Helper macro to use a previously defined fixture in a test, sharing it with the other tests of the same suite that use it.
+     The fixture is created the first time a test of the suite uses it and destroyed at the end of the suite, instead of once per test.
+     The fixture members are available for reading only using the prefix "F.", as tests run in parallel may access them concurrently.
+     Usage example:
+     @code
+     TEST(MyTest) {
+          SUITE_FIXTURE(MyFixture);         // created once for all the tests of the suite
+          T_ASSERT(F.myVar == 1);
+     }
+     @endcode
+     @see FIXTURE
+     */
+#   define SUITE_FIXTURE(fixtureName) \
+    const std::shared_ptr<const fixtureName##_TestFixture> __t_sharedFixture = \
+        ntk::TestSuite::fixturesOf(this).get<fixtureName##_TestFixture>(); \
+    const fixtureName##_TestFixture& F = *__t_sharedFixture; \
+    (void)F;
+    
+    /**
+     Helper macro to use a previously defined fixture in a test, sharing it with all the other tests that use it.
+     The fixture is created the first time a test uses it and destroyed at the end of the run.
+     The fixture members are available for reading only using the prefix "F.", as tests run in parallel may access them concurrently.
+     @see SUITE_FIXTURE
+     */
+#   define GLOBAL_FIXTURE(fixtureName) \
+    const std::shared_ptr<const fixtureName##_TestFixture> __t_sharedFixture = \
+        ntk::TestSharedFixtures::global().get<fixtureName##_TestFixture>(); \
+    const fixtureName##_TestFixture& F = *__t_sharedFixture; \
+    (void)F;
     
     /**
      Helper macro to declare a test suite.
@@ -750,8 +6844,10 @@ namespace ntk {
 #   define SUITE(suiteName) \
     class suiteName##_TestSuite : public ntk::TestSuite { \
     public: \
-        suiteName##_TestSuite() : ntk::TestSuite(#suiteName) { ntk::TestSuite::currentTestSuite(this); } \
-    } suiteName##_TestSuite_Instance
+        suiteName##_TestSuite() : ntk::TestSuite(ntk::Test::StaticName(#suiteName), ntk::TestType::TestSuite, false) {} \
+        __T_INSTANCE(suiteName##_TestSuite) \
+    }; \
+    __T_REGISTER(suiteName##_TestSuite, Suite, #suiteName, &suiteName##_TestSuite::instance, NULL)
     
     /**
      Helper macro to declare a sub test suite, i.e. a test suite that is part of a test suite.
@@ -763,7 +6859,7 @@ namespace ntk {
      SUITE(MySuite);
      
      // declare a sub test suite
-     SUBSUITE(MySuite, MySubSuite)
+     SUBSUITE(MySuite, MySubSuite);
      
      // all tests declared from here will be a part of MySubSuite
      @endcode
@@ -771,14 +6867,98 @@ namespace ntk {
 #   define SUBSUITE(parentSuiteName, subSuiteName) \
     class subSuiteName##_TestSuite : public ntk::TestSuite { \
     public: \
-        subSuiteName##_TestSuite() : ntk::TestSuite(#subSuiteName, ntk::TestType::TestSuite, false) { \
-            parentSuiteName##_TestSuite_Instance.addTest(this); \
-            ntk::TestSuite::currentTestSuite(this); \
-        } \
-    } subSuiteName##_TestSuite_Instance
+        subSuiteName##_TestSuite() : ntk::TestSuite(ntk::Test::StaticName(#subSuiteName), ntk::TestType::TestSuite, false) {} \
+        __T_INSTANCE(subSuiteName##_TestSuite) \
+    }; \
+    __T_REGISTER(subSuiteName##_TestSuite, SubSuite, #subSuiteName, &subSuiteName##_TestSuite::instance, &parentSuiteName##_TestSuite::instance)
+    
+    /**
+     Helper macro to declare a test suite whose tests must be run serially, i.e. never concurrently with any other test, when tests are run in parallel.
+     Sub suites of a serial suite are also run serially.
+     @see SUITE
+     */
+#   define SERIAL_SUITE(suiteName) \
+    class suiteName##_TestSuite : public ntk::TestSuite { \
+    public: \
+        suiteName##_TestSuite() : ntk::TestSuite(ntk::Test::StaticName(#suiteName), ntk::TestType::TestSuite, false) { setSerial(true); } \
+        __T_INSTANCE(suiteName##_TestSuite) \
+    }; \
+    __T_REGISTER(suiteName##_TestSuite, Suite, #suiteName, &suiteName##_TestSuite::instance, NULL)
+    
+    /**
+     Helper macro to declare a sub test suite whose tests must be run serially, i.e. never concurrently with any other test, when tests are run in 
+     parallel.
+     @see SUBSUITE
+     */
+#   define SERIAL_SUBSUITE(parentSuiteName, subSuiteName) \
+    class subSuiteName##_TestSuite : public ntk::TestSuite { \
+    public: \
+        subSuiteName##_TestSuite() : ntk::TestSuite(ntk::Test::StaticName(#subSuiteName), ntk::TestType::TestSuite, false) { setSerial(true); } \
+        __T_INSTANCE(subSuiteName##_TestSuite) \
+    }; \
+    __T_REGISTER(subSuiteName##_TestSuite, SubSuite, #subSuiteName, &subSuiteName##_TestSuite::instance, &parentSuiteName##_TestSuite::instance)
+    
+    /**
+     Helper macro to declare a test suite by its path, i.e. the names of its parent suites and its own name separated by "/".
+     Until a new test suite is declared in the same file, all tests declared after are considered as a part of this suite.
+     Suites are matched by name, so tests from any number of files can be added to the same suite, including a suite declared with SUITE or SUBSUITE 
+     in another file. The missing suites of the path are created as needed, and tests declared after a suite path are run after the other tests of the
+     suite, in the order of their file names.
+     Usage example:
+     @code
+     // in parser_tokens.cpp
+     SUITE_PATH("Net/Parser");
+     
+     // in parser_errors.cpp, tests declared from here will also be a part of the suite Parser in the suite Net
+     SUITE_PATH("Net/Parser");
+     @endcode
+     */
+#   define SUITE_PATH(suitePath) \
+    __T_SUITE_PATH(__T_CONCAT(SuitePath_, __LINE__), suitePath)
+    
+    // declares a suite path descriptor with an identifier unique in the file
+#   define __T_SUITE_PATH(identifier, suitePath) \
+    __T_REGISTER(identifier, SuitePath, suitePath, NULL, NULL)
+
+    /**
+     Helper macro replacing the global operator new and delete, so that the heap allocations of each test are counted (see ntk::TestAllocations).
+     This macro must be used only once in the program, for example before RUN_TESTS.
+     */
+#   define TRACK_ALLOCATIONS() \
+    void* operator new(std::size_t size) { \
+        void* memory = ntk::TestAllocations::allocate(size); \
+        if (memory == NULL) \
+            __T_BAD_ALLOC(); \
+        return memory; \
+    } \
+    void* operator new[](std::size_t size) { return operator new(size); } \
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return ntk::TestAllocations::allocate(size); } \
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return ntk::TestAllocations::allocate(size); } \
+    void operator delete(void* pointer) noexcept { ntk::TestAllocations::deallocate(pointer); } \
+    void operator delete[](void* pointer) noexcept { ntk::TestAllocations::deallocate(pointer); } \
+    void operator delete(void* pointer, const std::nothrow_t&) noexcept { ntk::TestAllocations::deallocate(pointer); } \
+    void operator delete[](void* pointer, const std::nothrow_t&) noexcept { ntk::TestAllocations::deallocate(pointer); } \
+    __T_SIZED_DELETE \
+    static const bool __t_allocationsTracked = ntk::TestAllocations::setTracked()
+    
+#ifndef DO_NOT_USE_EXCEPTIONS
+#   define __T_BAD_ALLOC()  throw std::bad_alloc()
+#else
+#   define __T_BAD_ALLOC()  std::abort()    // the failure can't be reported without exceptions
+#endif
+    
+#if defined (__cpp_sized_deallocation)
+#   define __T_SIZED_DELETE \
+    void operator delete(void* pointer, std::size_t) noexcept { ntk::TestAllocations::deallocate(pointer); } \
+    void operator delete[](void* pointer, std::size_t) noexcept { ntk::TestAllocations::deallocate(pointer); }
+#else
+#   define __T_SIZED_DELETE
+#endif
 
     /**
      Helper macro to create a main() function that will run all the tests, using the result class provided.
+     The tests to run and how to run them can be specified on the command line (see TestOptions::parse(), or run with --help), as well as another
+     report of the results, such as JUnit XML or JSON lines (see TestOptions::report).
      This macro must be used only once, at the end of the tests.
      Usage example:
      @code
@@ -789,8 +6969,15 @@ namespace ntk {
      */
 #   define RUN_TESTS(resultClassName) \
     int main(int argc, char* argv[]) { \
+        ntk::TestOptions options;\
+        if (!options.parse(argc, argv))\
+            return EXIT_FAILURE;\
+        if (options.list)\
+            return ntk::Test::listAll(std::cout, options);\
+        if ((options.report != ntk::TestOptions::DefaultReport) || !options.outputFile.empty())\
+            return (ntk::Test::runAll(options) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;\
         resultClassName results;\
-        return ntk::Test::runAll(results);\
+        return (ntk::Test::runAll(results, options) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;\
     }\
     
 #pragma mark -
@@ -799,110 +6986,278 @@ namespace ntk {
     /** Asserts that the specified predicate is true. An additional explanation message may be provided. */
 #   define TM_CHECK(predicate, message) \
     __E_TRY \
-    if (!(predicate)) { \
-        __T_FAIL(#predicate, message); \
-        return; \
-    } \
+    __T_CHECK(__T_ASSERT_FAILURE, predicate, message) \
     __E_CATCH
 #   define T_CHECK(predicate)       TM_CHECK(predicate, "")     ///< Same as TM_CHECK, without message.
     
     /** Asserts that the values of x and y are equal. An additional explanation message may be provided. */
 #   define TM_CHECK_EQUAL(x, y, message) \
     __E_TRY \
-    __T_CHECK2(equal, "==", x, y, message) \
+    __T_CHECK2(__T_ASSERT_FAILURE, equal, "==", x, y, message) \
     __E_CATCH 
 #   define T_CHECK_EQUAL(x, y)      TM_CHECK_EQUAL(x, y, "")    ///< Same as TM_CHECK_EQUAL, without message.
     
     /** Asserts that the values of x and y differ. An additional explanation message may be provided. */
 #   define TM_CHECK_DIFFER(x, y, message) \
     __E_TRY \
-    __T_CHECK2(differ, "!=", x, y, message) \
+    __T_CHECK2(__T_ASSERT_FAILURE, differ, "!=", x, y, message) \
     __E_CATCH 
 #   define T_CHECK_DIFFER(x, y)     TM_CHECK_DIFFER(x, y, "")   ///< Same as TM_CHECK_DIFFER, without message.
 
     /** Asserts that the values of x and y are close, with a maximum delta of d. An additional explanation message may be provided. */
 #   define TM_CHECK_CLOSE(x, y, d, message) \
     __E_TRY \
-    __T_CHECK3(close, "close to", "with delta", x, y, d, message) \
+    __T_CHECK3(__T_ASSERT_FAILURE, close, "close to", "with delta", x, y, d, message) \
     __E_CATCH 
 #   define T_CHECK_CLOSE(x, y, d)   TM_CHECK_CLOSE(x, y, d, "") ///< Same as TM_CHECK_CLOSE, without message.
 
     /** Asserts that the value of x is less than y. An additional explanation message may be provided. */
 #   define TM_CHECK_LESS_THAN(x, y, message) \
     __E_TRY \
-    __T_CHECK2(less, "<", x, y, message) \
+    __T_CHECK2(__T_ASSERT_FAILURE, less, "<", x, y, message) \
     __E_CATCH 
 #   define T_CHECK_LESS_THAN(x, y)  TM_CHECK_LESS_THAN(x, y, "")    ///< Same as TM_CHECK_LESS_THAN, without message.
   
     /** Asserts that the value of x is less or equal than y. An additional explanation message may be provided. */
 #   define TM_CHECK_LESS_OR_EQUAL(x, y, message) \
     __E_TRY \
-    __T_CHECK2(lessOrEqual, "<=", x, y, message) \
+    __T_CHECK2(__T_ASSERT_FAILURE, lessOrEqual, "<=", x, y, message) \
     __E_CATCH 
 #   define T_CHECK_LESS_OR_EQUAL(x, y)  TM_CHECK_LESS_OR_EQUAL(x, y, "")    ///< Same as TM_CHECK_LESS_OR_EQUAL, without message.
 
     /** Asserts that the value of x is more than y. An additional explanation message may be provided. */
 #   define TM_CHECK_MORE_THAN(x, y, message) \
     __E_TRY \
-    __T_CHECK2(more, ">", x, y, message) \
+    __T_CHECK2(__T_ASSERT_FAILURE, more, ">", x, y, message) \
     __E_CATCH 
 #   define T_CHECK_MORE_THAN(x, y)  TM_CHECK_MORE_THAN(x, y, "")    ///< Same as TM_CHECK_MORE_THAN, without message.
 
     /** Asserts that the value of x is more or equal than y. An additional explanation message may be provided. */
 #   define TM_CHECK_MORE_OR_EQUAL(x, y, message) \
     __E_TRY \
-    __T_CHECK2(moreOrEqual, ">=", x, y, message) \
+    __T_CHECK2(__T_ASSERT_FAILURE, moreOrEqual, ">=", x, y, message) \
     __E_CATCH 
 #   define T_CHECK_MORE_OR_EQUAL(x, y)  TM_CHECK_MORE_OR_EQUAL(x, y, "")    ///< Same as TM_CHECK_MORE_OR_EQUAL, without message.
 
-    /** Asserts that the objects x and y of size s have the same data. An additional explanation message may be provided. */
+    /**
+     Asserts that the objects x and y of size s have the same data. An additional explanation message may be provided.
+     On failure the number of differing bytes and the bytes around the first difference are reported.
+     */
 #   define TM_CHECK_SAME_DATA(x, y, s, message) \
     __E_TRY \
-    __T_CHECK3_NOPRINT(sameData, "has same data as", "with size", x, y, s, message) \
+    __T_CHECK_DATA(__T_ASSERT_FAILURE, x, y, s, message) \
     __E_CATCH 
 #   define T_CHECK_SAME_DATA(x, y, s)   TM_CHECK_SAME_DATA(x, y, s, "") ///< Same as TM_CHECK_SAME_DATA, without message.
+    
+    /**
+     Asserts that all the elements of the ranges x and y (containers or arrays) are equal. An additional explanation message may be provided.
+     On failure the number of mismatching elements, the first mismatching indices and for arithmetic values the maximum errors are reported.
+     */
+#   define TM_CHECK_RANGE_EQUAL(x, y, message) \
+    __E_TRY \
+    __T_CHECK_RANGE(__T_ASSERT_FAILURE, compareEqual(x, y), #x " == " #y " for all elements", message) \
+    __E_CATCH 
+#   define T_CHECK_RANGE_EQUAL(x, y)    TM_CHECK_RANGE_EQUAL(x, y, "")  ///< Same as TM_CHECK_RANGE_EQUAL, without message.
+    
+    /**
+     Asserts that all the elements of the ranges x and y (containers or arrays) are close, with a maximum delta of d. An additional explanation 
+     message may be provided. On failure the number of mismatching elements, the first mismatching indices and the maximum errors are reported.
+     */
+#   define TM_CHECK_ALL_CLOSE(x, y, d, message) \
+    __E_TRY \
+    __T_CHECK_RANGE(__T_ASSERT_FAILURE, compareClose(x, y, d), #x " close to " #y " with delta " #d " for all elements", message) \
+    __E_CATCH 
+#   define T_CHECK_ALL_CLOSE(x, y, d)   TM_CHECK_ALL_CLOSE(x, y, d, "") ///< Same as TM_CHECK_ALL_CLOSE, without message.
+    
+    /**
+     Asserts that the block of code that follows makes at most the specified number of heap allocations. An additional explanation message may be 
+     provided. Allocations can only be counted if the global operator new and delete are replaced using TRACK_ALLOCATIONS, otherwise the check fails.
+     Usage example:
+     @code
+     T_CHECK_MAX_ALLOCS(0) {
+         // code that must not allocate memory goes here
+     }
+     @endcode
+     */
+#   define TM_CHECK_MAX_ALLOCS(maxAllocations, message) \
+    __T_CHECK_ALLOCS(__T_ASSERT_FAILURE, maxAllocations, message)
+#   define T_CHECK_MAX_ALLOCS(maxAllocations)  TM_CHECK_MAX_ALLOCS(maxAllocations, "")   ///< Same as TM_CHECK_MAX_ALLOCS, without message.
+    
+    /**
+     Asserts that the median duration of the specified expression is below the specified budget, given as a std::chrono duration or a number of 
+     nanoseconds. The expression is sampled repeatedly, and the check only fails if the budget is exceeded with statistical confidence (see 
+     ntk::TestCheck::TimingEstimate). An additional explanation message may be provided.
+     Usage example:
+     @code
+     T_CHECK_DURATION_BELOW(std::sort(v.begin(), v.end()), std::chrono::milliseconds(5));
+     @endcode
+     */
+#   define TM_CHECK_DURATION_BELOW(expression, budget, message) \
+    __E_TRY \
+    __T_CHECK_DURATION(__T_ASSERT_FAILURE, expression, budget, message) \
+    __E_CATCH
+#   define T_CHECK_DURATION_BELOW(expression, budget)   TM_CHECK_DURATION_BELOW(expression, budget, "") ///< Same as TM_CHECK_DURATION_BELOW, without message.
+    
+    /**
+     Asserts that the expression a runs faster than the expression b by the specified factor, i.e. that the median of the duration of b divided by the
+     duration of a is at least the ratio. Both expressions are sampled alternately, and the check only fails if the speedup is below the ratio with 
+     statistical confidence (see ntk::TestCheck::TimingEstimate). An additional explanation message may be provided.
+     */
+#   define TM_CHECK_FASTER_THAN(a, b, ratio, message) \
+    __E_TRY \
+    __T_CHECK_SPEEDUP(__T_ASSERT_FAILURE, a, b, ratio, message) \
+    __E_CATCH
+#   define T_CHECK_FASTER_THAN(a, b, ratio) TM_CHECK_FASTER_THAN(a, b, ratio, "")  ///< Same as TM_CHECK_FASTER_THAN, without message.
 
     /** Asserts that the specified method throws an exception of the specified type. An additional explanation message may be provided. */
 #   define TM_CHECK_THROWS(method, exception, message) \
     __E_TRY \
-    try { \
-        method; \
-        __T_FAIL(#method " throws exception " #exception, message); \
-        return; \
-    } catch(exception) {} \
+    __T_CHECK_THROWS(__T_ASSERT_FAILURE, method, exception, message) \
     __E_CATCH 
 #   define T_CHECK_THROWS(method, exception)   TM_CHECK_THROWS(method, exception, "")  ///< Same as TM_CHECK_THROWS, without message.
     
     /** Asserts that the specified method throws any exception. An additional explanation message may be provided. */
 #   define TM_CHECK_THROWS_ANY(method, message) \
-    __T_MULTILINE_BEGIN \
-    try { \
-        method; \
-        __T_FAIL(#method " throws any exception", message); \
-        return; \
-    } catch(...) {} \
-    __T_MULTILINE_END
+    __T_CHECK_THROWS_ANY(__T_ASSERT_FAILURE, method, message)
 #   define T_CHECK_THROWS_ANY(method)   TM_CHECK_THROWS_ANY(method, "") ///< Same as TM_CHECK_THROWS_ANY, without message.
     
     /** Asserts that the specified method does not throw any exception. An additional explanation message may be provided. */
 #   define TM_CHECK_NOTHROW(method, message) \
-    __T_MULTILINE_BEGIN \
-    try { \
-        method; \
-    } catch(...) { \
-        __T_FAIL(#method " does not throw exception", message); \
-        return; \
-    } \
-    __T_MULTILINE_END
+    __T_CHECK_NOTHROW(__T_ASSERT_FAILURE, method, message)
 #   define T_CHECK_NOTHROW(method)  TM_CHECK_NOTHROW(method, "")    ///< Same as TM_CHECK_NOTHROW, without message.
     
     /** Explicitely fails the current test. An additional explanation message may be provided. */
-#   define TM_CHECK_FAIL(message) \
-    __T_MULTILINE_BEGIN \
-    __T_FAIL("Explicit failure", message); \
-    return; \
-    __T_MULTILINE_END
+#   define TM_CHECK_FAIL(message)   __T_ASSERT_FAILURE("Explicit failure", message)
 #   define T_CHECK_FAIL()           TM_CHECK_FAIL("")   ///< Same as TM_CHECK_FAIL, without message.
+    
+#pragma mark -
+#pragma mark Soft assertion macros
+    
+    /**
+     Checks that the specified predicate is true, like TM_CHECK, but a failed soft check is only reported and the test goes on. The failures of 
+     the soft checks of a test are reported up to the limit given in ntk::TestOptions (100 by default), the test is then stopped. An unhandled 
+     exception still stops the test. An additional explanation message may be provided.
+     Usage example:
+     @code
+     for (size_t i = 0; i < values.size(); ++i)
+         TE_CHECK_EQUAL(values[i], expected[i]);    // all the mismatches are reported
+     @endcode
+     */
+#   define TEM_CHECK(predicate, message) \
+    __E_TRY \
+    __T_CHECK(__T_SOFT_FAILURE, predicate, message) \
+    __E_CATCH
+#   define TE_CHECK(predicate)      TEM_CHECK(predicate, "")    ///< Same as TEM_CHECK, without message.
+    
+    /** Same as TM_CHECK_EQUAL, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_EQUAL(x, y, message) \
+    __E_TRY \
+    __T_CHECK2(__T_SOFT_FAILURE, equal, "==", x, y, message) \
+    __E_CATCH 
+#   define TE_CHECK_EQUAL(x, y)     TEM_CHECK_EQUAL(x, y, "")   ///< Same as TEM_CHECK_EQUAL, without message.
+    
+    /** Same as TM_CHECK_DIFFER, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_DIFFER(x, y, message) \
+    __E_TRY \
+    __T_CHECK2(__T_SOFT_FAILURE, differ, "!=", x, y, message) \
+    __E_CATCH 
+#   define TE_CHECK_DIFFER(x, y)    TEM_CHECK_DIFFER(x, y, "")  ///< Same as TEM_CHECK_DIFFER, without message.
+    
+    /** Same as TM_CHECK_CLOSE, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_CLOSE(x, y, d, message) \
+    __E_TRY \
+    __T_CHECK3(__T_SOFT_FAILURE, close, "close to", "with delta", x, y, d, message) \
+    __E_CATCH 
+#   define TE_CHECK_CLOSE(x, y, d)  TEM_CHECK_CLOSE(x, y, d, "")    ///< Same as TEM_CHECK_CLOSE, without message.
+    
+    /** Same as TM_CHECK_LESS_THAN, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_LESS_THAN(x, y, message) \
+    __E_TRY \
+    __T_CHECK2(__T_SOFT_FAILURE, less, "<", x, y, message) \
+    __E_CATCH 
+#   define TE_CHECK_LESS_THAN(x, y) TEM_CHECK_LESS_THAN(x, y, "")   ///< Same as TEM_CHECK_LESS_THAN, without message.
+    
+    /** Same as TM_CHECK_LESS_OR_EQUAL, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_LESS_OR_EQUAL(x, y, message) \
+    __E_TRY \
+    __T_CHECK2(__T_SOFT_FAILURE, lessOrEqual, "<=", x, y, message) \
+    __E_CATCH 
+#   define TE_CHECK_LESS_OR_EQUAL(x, y) TEM_CHECK_LESS_OR_EQUAL(x, y, "")   ///< Same as TEM_CHECK_LESS_OR_EQUAL, without message.
+    
+    /** Same as TM_CHECK_MORE_THAN, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_MORE_THAN(x, y, message) \
+    __E_TRY \
+    __T_CHECK2(__T_SOFT_FAILURE, more, ">", x, y, message) \
+    __E_CATCH 
+#   define TE_CHECK_MORE_THAN(x, y) TEM_CHECK_MORE_THAN(x, y, "")   ///< Same as TEM_CHECK_MORE_THAN, without message.
+    
+    /** Same as TM_CHECK_MORE_OR_EQUAL, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_MORE_OR_EQUAL(x, y, message) \
+    __E_TRY \
+    __T_CHECK2(__T_SOFT_FAILURE, moreOrEqual, ">=", x, y, message) \
+    __E_CATCH 
+#   define TE_CHECK_MORE_OR_EQUAL(x, y) TEM_CHECK_MORE_OR_EQUAL(x, y, "")   ///< Same as TEM_CHECK_MORE_OR_EQUAL, without message.
+    
+    /** Same as TM_CHECK_SAME_DATA, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_SAME_DATA(x, y, s, message) \
+    __E_TRY \
+    __T_CHECK_DATA(__T_SOFT_FAILURE, x, y, s, message) \
+    __E_CATCH 
+#   define TE_CHECK_SAME_DATA(x, y, s)  TEM_CHECK_SAME_DATA(x, y, s, "")    ///< Same as TEM_CHECK_SAME_DATA, without message.
+    
+    /** Same as TM_CHECK_RANGE_EQUAL, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_RANGE_EQUAL(x, y, message) \
+    __E_TRY \
+    __T_CHECK_RANGE(__T_SOFT_FAILURE, compareEqual(x, y), #x " == " #y " for all elements", message) \
+    __E_CATCH 
+#   define TE_CHECK_RANGE_EQUAL(x, y)   TEM_CHECK_RANGE_EQUAL(x, y, "") ///< Same as TEM_CHECK_RANGE_EQUAL, without message.
+    
+    /** Same as TM_CHECK_ALL_CLOSE, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_ALL_CLOSE(x, y, d, message) \
+    __E_TRY \
+    __T_CHECK_RANGE(__T_SOFT_FAILURE, compareClose(x, y, d), #x " close to " #y " with delta " #d " for all elements", message) \
+    __E_CATCH 
+#   define TE_CHECK_ALL_CLOSE(x, y, d)  TEM_CHECK_ALL_CLOSE(x, y, d, "")    ///< Same as TEM_CHECK_ALL_CLOSE, without message.
+    
+    /** Same as TM_CHECK_MAX_ALLOCS, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_MAX_ALLOCS(maxAllocations, message) \
+    __T_CHECK_ALLOCS(__T_SOFT_FAILURE, maxAllocations, message)
+#   define TE_CHECK_MAX_ALLOCS(maxAllocations) TEM_CHECK_MAX_ALLOCS(maxAllocations, "") ///< Same as TEM_CHECK_MAX_ALLOCS, without message.
+    
+    /** Same as TM_CHECK_DURATION_BELOW, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_DURATION_BELOW(expression, budget, message) \
+    __E_TRY \
+    __T_CHECK_DURATION(__T_SOFT_FAILURE, expression, budget, message) \
+    __E_CATCH
+#   define TE_CHECK_DURATION_BELOW(expression, budget)  TEM_CHECK_DURATION_BELOW(expression, budget, "")    ///< Same as TEM_CHECK_DURATION_BELOW, without message.
+    
+    /** Same as TM_CHECK_FASTER_THAN, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_FASTER_THAN(a, b, ratio, message) \
+    __E_TRY \
+    __T_CHECK_SPEEDUP(__T_SOFT_FAILURE, a, b, ratio, message) \
+    __E_CATCH
+#   define TE_CHECK_FASTER_THAN(a, b, ratio)    TEM_CHECK_FASTER_THAN(a, b, ratio, "")  ///< Same as TEM_CHECK_FASTER_THAN, without message.
+    
+    /** Same as TM_CHECK_THROWS, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_THROWS(method, exception, message) \
+    __E_TRY \
+    __T_CHECK_THROWS(__T_SOFT_FAILURE, method, exception, message) \
+    __E_CATCH 
+#   define TE_CHECK_THROWS(method, exception)  TEM_CHECK_THROWS(method, exception, "") ///< Same as TEM_CHECK_THROWS, without message.
+    
+    /** Same as TM_CHECK_THROWS_ANY, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_THROWS_ANY(method, message) \
+    __T_CHECK_THROWS_ANY(__T_SOFT_FAILURE, method, message)
+#   define TE_CHECK_THROWS_ANY(method)  TEM_CHECK_THROWS_ANY(method, "")    ///< Same as TEM_CHECK_THROWS_ANY, without message.
+    
+    /** Same as TM_CHECK_NOTHROW, as a soft check (see TEM_CHECK). */
+#   define TEM_CHECK_NOTHROW(method, message) \
+    __T_CHECK_NOTHROW(__T_SOFT_FAILURE, method, message)
+#   define TE_CHECK_NOTHROW(method) TEM_CHECK_NOTHROW(method, "")   ///< Same as TEM_CHECK_NOTHROW, without message.
+    
+    /** Explicitely reports a failure of the current test, which goes on (see TEM_CHECK). An additional explanation message may be provided. */
+#   define TEM_CHECK_FAIL(message)  __T_SOFT_FAILURE("Explicit failure", message)
+#   define TE_CHECK_FAIL()          TEM_CHECK_FAIL("")  ///< Same as TEM_CHECK_FAIL, without message.
         
 } // namespace ntk
 
@@ -30,8 +30,19 @@
 
 #include "test.hpp"
 
+#include <cstdio>
+#include <cstdlib>
+
 SUITE(NTK_Unit);
 
+// gets a path in the temporary directory for a file of the specified name
+static std::string temporaryPath(const char* name) {
+    const char* directory = std::getenv("TMPDIR");
+    if ((directory == NULL) || (*directory == '\0'))
+        directory = std::getenv("TEMP");
+    return std::string(((directory != NULL) && (*directory != '\0')) ? directory : "/tmp") + "/" + name;
+}
+
 // -- Test all assertions macros ---------------------------------
 
 SUBSUITE(NTK_Unit, Assertions);
@@ -103,6 +114,28 @@ TEST(CheckSameData) {
     USE_FIXTURE(AssertionsFixture);
     char data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
     T_CHECK_SAME_DATA(F.d, data, 10);
+    
+    std::vector<char> large(100003, 'x');
+    std::vector<char> copy(large);
+    T_CHECK_SAME_DATA(&large[1], &copy[1], large.size() - 1);
+    copy[18] = copy[19] = copy[50001] = 'y';
+    ntk::TestCheck::DataDifference difference(&large[1], &copy[1], large.size() - 1);
+    T_CHECK_EQUAL(difference.offset(), 17u);
+    T_CHECK_EQUAL(difference.count(), 3u);
+}
+
+TEST(CheckRangeEqual) {
+    USE_FIXTURE(AssertionsFixture);
+    char data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    std::vector<int> values(data, data + 10);
+    T_CHECK_RANGE_EQUAL(F.d, data);
+    T_CHECK_RANGE_EQUAL(values, F.d);
+}
+
+TEST(CheckAllClose) {
+    std::vector<double> values(1000, 3.0001);
+    std::vector<float> expected(1000, 3.0f);
+    T_CHECK_ALL_CLOSE(values, expected, 0.001);
 }
 
 TEST(CheckThrows) {
@@ -118,6 +151,28 @@ TEST(CheckNoThrow) {
     T_CHECK_NOTHROW(i++);
 }
 
+TEST(SoftChecks) {
+    std::vector<int> values(10, 2);
+    for (size_t i = 0; i < values.size(); ++i)
+        TE_CHECK_EQUAL(values[i], 2);
+    TE_CHECK(true);
+    TE_CHECK_CLOSE(3.0001, 3.0, 0.001);
+    TE_CHECK_THROWS(throw 1, int);
+    TE_CHECK_NOTHROW((void)values.size());
+    
+    // the failure reporting the limit goes to this result instead of the run
+    ntk::TestResult limited;
+    unsigned int reported = 0;
+    while ((reported < 1000) && countSoftFailure(limited, __FILE__, __LINE__))
+        ++reported;
+    T_CHECK_EQUAL(reported, 100u);
+    T_CHECK_EQUAL(limited.failures(), 1);
+}
+
+TEST_TIMEOUT(CheckTimeout, 10000) {
+    T_CHECK(true);
+}
+
 // -- Test all assertions macros failures ------------------------
 
 SUBSUITE(NTK_Unit, Failures);
@@ -189,6 +244,27 @@ TEST(CheckSameDataFailure) {
     TM_CHECK_SAME_DATA(F.d, data, 10, "This test should fail");
 }
 
+TEST(CheckRangeEqualFailure) {
+    USE_FIXTURE(FailuresFixture);
+    char data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    TM_CHECK_RANGE_EQUAL(F.d, data, "This test should fail");
+}
+
+TEST(CheckMaxAllocsFailure) {
+    TM_CHECK_MAX_ALLOCS(0, "This test should fail") {
+        std::vector<int> values(10);
+        ntk::TestBenchmark::doNotOptimize(values[0]);
+    }
+}
+
+TEST(CheckAllCloseFailure) {
+    std::vector<double> values(1000, 3.0001);
+    std::vector<double> expected(values);
+    expected[10] = 3.1;
+    expected[500] = 2.9;
+    TM_CHECK_ALL_CLOSE(values, expected, 0.001, "This test should fail");
+}
+
 TEST(CheckThrowsFailure) {
     int i = 0;
     TM_CHECK_THROWS(i++, int, "This test should fail");
@@ -203,17 +279,444 @@ TEST(CheckNoThrowFailure) {
     TM_CHECK_NOTHROW(throw 1, "This test should fail");
 }
 
+TEST_DATA(MissingDataFile, "missing_test_data_should_fail.txt") {
+    T_CHECK_MORE_THAN(param.size, 0u);
+}
+
+TEST(SoftCheckFailures) {
+    for (int i = 0; i < 2; ++i)
+        TEM_CHECK_EQUAL(i, 2, "This check should fail twice");
+    TEM_CHECK_FAIL("This test should go on after the failed soft checks");
+}
+
 TEST(CheckFail) {
     TM_CHECK_FAIL("This test should fail");
 }
 
+// -- Test benchmarks -------------------------------------------
+
+SUBSUITE(NTK_Unit, Benchmarks);
+
+BENCHMARK(Benchmark) {
+    USE_FIXTURE(AssertionsFixture);
+    int sum = 0;
+    BENCHMARK_LOOP {
+        sum += F.d[F.i];
+        ntk::TestBenchmark::doNotOptimize(sum);
+    }
+    T_CHECK_MORE_THAN(sum, 0);
+}
+
+TEST(CounterStats) {
+    ntk::TestCounters::Counts counts(0.0);
+    counts.values[ntk::TestCounters::Cycles] = 2000;
+    counts.values[ntk::TestCounters::Instructions] = 3000;
+    counts.values[ntk::TestCounters::CacheReferences] = 100;
+    counts.values[ntk::TestCounters::CacheMisses] = 5;
+    counts.values[ntk::TestCounters::BranchMisses] = -1;
+    ntk::TestCounters::add(counts, ntk::TestCounters::Counts(0.0));
+    ntk::TestCounterStats stats = ntk::TestCounters::statsOf(counts, 10);
+    T_CHECK_CLOSE(stats.instructions, 300.0, 1e-9);
+    T_CHECK_CLOSE(stats.ipc(), 1.5, 1e-9);
+    T_CHECK_CLOSE(stats.cacheMissRate(), 0.05, 1e-9);
+    T_CHECK_LESS_THAN(stats.branchMissRate(), 0.0);
+    T_CHECK(!ntk::TestCounters::Counts().isCounted());
+}
+
+TEST(BenchmarkComparison) {
+    std::vector<double> reference, same, slower;
+    for (int i = 0; i < 20; ++i) {
+        reference.push_back(100.0 + i);
+        same.push_back(100.5 + i);
+        slower.push_back(150.0 + i);
+    }
+    ntk::TestBenchmarkDelta delta = ntk::TestBenchmarkDelta::between(same, reference);
+    T_CHECK(!delta.isSignificant());
+    T_CHECK_LESS_THAN(delta.lower, 1.0);
+    T_CHECK_MORE_THAN(delta.upper, 1.0);
+    delta = ntk::TestBenchmarkDelta::between(slower, reference);
+    T_CHECK(delta.isSignificant());
+    T_CHECK_LESS_THAN(delta.pValue, 1e-6);
+    T_CHECK_CLOSE(delta.ratio, 1.5, 0.05);
+    T_CHECK_LESS_OR_EQUAL(delta.lower, delta.ratio);
+    T_CHECK_MORE_OR_EQUAL(delta.upper, delta.ratio);
+    
+    ntk::TestBenchmarkSamples samples(10);
+    samples.set("Suite/Benchmark", reference);
+    T_CHECK(samples.get("Suite/Other") == NULL);
+    T_CHECK_EQUAL(samples.get("Suite/Benchmark")->size(), 20u);
+    T_CHECK(samples.isRegression(delta));
+    T_CHECK(!ntk::TestBenchmarkSamples(60).isRegression(delta));
+}
+
+// -- Test timing ---------------------------------------------
+
+SUBSUITE(NTK_Unit, Timing);
+
+static int sumValues(const std::vector<int>& values, size_t count) {
+    int sum = 0;
+    for (size_t i = 0; i < count; ++i)
+        sum += values[i];
+    return sum;
+}
+
+TEST(CheckDurationBelow) {
+    std::vector<int> values(1000, 1);
+    T_CHECK_DURATION_BELOW(ntk::TestBenchmark::doNotOptimize(sumValues(values, values.size())), std::chrono::milliseconds(100));
+}
+
+TEST(CheckFasterThan) {
+    std::vector<int> values(100000, 1);
+    T_CHECK_FASTER_THAN(ntk::TestBenchmark::doNotOptimize(sumValues(values, 100)), 
+                        ntk::TestBenchmark::doNotOptimize(sumValues(values, values.size())), 2);
+}
+
+TEST(CheckProfile) {
+    ntk::TestCheckProfile::Sites sites;
+    ntk::TestCheckProfile::Sites* testSites = ntk::TestCheckProfile::record(&sites);
+    for (int i = 0; i < 3; ++i)
+        ntk::TestCheckProfile::add("profiled.cpp", 10, 100);
+    ntk::TestCheckProfile::add("profiled.cpp", 20, 5);
+    ntk::TestCheckProfile::record(testSites);
+    
+    T_CHECK_EQUAL(sites.size(), 2u);
+    ntk::TestCheckStats stats = ntk::TestCheckProfile::statsOf(sites[0]);
+    T_CHECK_EQUAL(stats.file, "profiled.cpp");
+    T_CHECK_EQUAL(stats.line, 10);
+    T_CHECK_EQUAL(stats.count, 3);
+    T_CHECK_EQUAL(stats.duration, 300);
+    
+    std::ostringstream output;
+    ntk::OStreamTestResult profiled(output);
+    ntk::TestSuite fast("Fast", ntk::TestType::TestSuite, false);
+    ntk::TestSuite slow("Slow", ntk::TestType::TestSuite, false);
+    profiled.testBegins(&fast);
+    profiled.checkResult(&fast, stats);
+    profiled.testEnds(&fast);
+    profiled.testBegins(&slow);
+    profiled.checkResult(&slow, ntk::TestCheckProfile::statsOf(sites[1]));
+    profiled.checkResult(&slow, stats);
+    profiled.checkResult(&slow, stats);
+    profiled.testEnds(&slow);
+    profiled.allTestsEnd();
+    std::string report = output.str();
+    T_CHECK(report.find("  - Slow: ") < report.find("  - Fast: "));     // the slowest test first, each with its assertion sites
+    T_CHECK(report.find(" at profiled.cpp(20)") > report.find("  - Slow: "));
+    T_CHECK(report.find(" at profiled.cpp(20)") < report.find("  - Fast: "));
+}
+
+// -- Test memory ---------------------------------------------
+
+SUBSUITE(NTK_Unit, Memory);
+
+TEST(Arena) {
+    const char* text = arena().copy(std::string("scratch text"));
+    T_CHECK_EQUAL(std::string(text), "scratch text");
+    double* values = arena().allocateArray<double>(100000);
+    T_CHECK_EQUAL((uintptr_t)values % alignof(double), 0u);
+    values[99999] = 1.0;
+}
+
+TEST(InternedStrings) {
+    ntk::TestStrings strings;
+    const char* text = strings.intern("interned text");
+    T_CHECK_EQUAL(strings.intern(std::string("interned text").c_str()), text);
+    T_CHECK_EQUAL(std::string(text), "interned text");
+    ntk::TestFailure failure("condition", std::string(name()), __FILE__, __LINE__);
+    ntk::TestFailure copy(failure);
+    T_CHECK_EQUAL(copy.fileName(), failure.fileName());     // the copies of a failure share its file name
+}
+
+TEST(RecordPaths) {
+    ntk::TestTiming timing("", ntk::TestType::TestCase, 0, 0);
+    {
+        ntk::TestResult result;
+        result.testBegins(this);
+        result.testEnds(this);
+        ntk::TestResult copy(result);
+        timing = copy.timings().back();
+    }
+    T_CHECK(timing.path() == name());   // the paths of the records are interned and outlive the result
+}
+
+TEST(CheckMaxAllocs) {
+    T_CHECK_MAX_ALLOCS(0) {
+        int sum = 0;
+        for (int i = 0; i < 10; ++i)
+            sum += i;
+        ntk::TestBenchmark::doNotOptimize(sum);
+    }
+    T_CHECK_MAX_ALLOCS(1) {
+        std::unique_ptr<int> value(new int(1));
+        ntk::TestBenchmark::doNotOptimize(*value);
+    }
+}
+
+// -- Test shared fixtures ------------------------------------
+
+SUBSUITE(NTK_Unit, SharedFixtures);
+
+static std::atomic<int> sharedFixtureSetups(0);
+
+FIXTURE(SharedFixture) {
+    int setup;
+    
+    SETUP(SharedFixture) {
+        setup = ++sharedFixtureSetups;
+    }
+};
+
+TEST(SuiteFixture) {
+    SUITE_FIXTURE(SharedFixture);
+    T_CHECK_EQUAL(F.setup, sharedFixtureSetups.load());
+}
+
+TEST(SuiteFixtureReused) {
+    SUITE_FIXTURE(SharedFixture);
+    T_CHECK_EQUAL(F.setup, sharedFixtureSetups.load());
+}
+
+TEST(GlobalFixture) {
+    GLOBAL_FIXTURE(SharedFixture);
+    T_CHECK_MORE_THAN(F.setup, 0);
+}
+
+// -- Test pooled fixtures ------------------------------------
+
+SUBSUITE(NTK_Unit, PooledFixtures);
+
+FIXTURE(PooledFixture) {
+    std::vector<int> buffer;
+    int resets;
+    
+    SETUP(PooledFixture) : buffer(100000), resets(0) {}
+    
+    RESET(PooledFixture) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        ++resets;
+    }
+};
+
+TEST(PooledFixture) {
+    USE_FIXTURE(PooledFixture);
+    T_CHECK_EQUAL(F.buffer.size(), 100000u);
+    T_CHECK_EQUAL(F.buffer[10], 0);
+    F.buffer[10] = 1;
+}
+
+TEST(PooledFixtureReset) {
+    const PooledFixture_TestFixture* instance = NULL;
+    int resets = 0;
+    {
+        USE_FIXTURE(PooledFixture);     // the fixture of a previous test run by this thread, given back to the pool when it ends
+        instance = &F;
+        resets = F.resets;
+        F.buffer[10] = 1;
+    }
+    USE_FIXTURE(PooledFixture);
+    T_CHECK(&F == instance);
+    T_CHECK_EQUAL(F.resets, resets + 1);
+    T_CHECK_EQUAL(F.buffer.size(), 100000u);
+    T_CHECK_EQUAL(F.buffer[10], 0);
+}
+
+// -- Test parameterized tests -------------------------------
+
+SUBSUITE(NTK_Unit, Parameterized);
+
+TEST_P(RangeValues, ntk::TestRange<int>(1, 10, 3)) {
+    T_CHECK_EQUAL((param - 1) % 3, 0);
+    T_CHECK_LESS_THAN(param, 10);
+}
+
+TEST_P(VectorValues, std::vector<std::string>({ "a", "bb", "ccc" })) {
+    T_CHECK_EQUAL(param, std::string(param.size(), param[0]));
+    T_CHECK_EQUAL(ntk::Test::pathOf(this), "NTK_Unit/Parameterized/VectorValues/" + std::to_string(param.size() - 1));
+}
+
+TEST(DataFileBatches) {
+    std::string fileName = temporaryPath("ntk_unit_test_data.tmp");
+    std::ofstream(fileName.c_str(), std::ios::binary) << "first\n\nthird line\nlast";
+    ntk::TestDataFile file(fileName, '\n', 4);
+    std::vector<std::string> cases;
+    for (size_t i = 0; i < file.batchCount(); ++i) {
+        ntk::TestDataFile::Reader reader(file, i);
+        while (reader.next())
+            cases.push_back(reader.name() + ":" + reader.parameter().str());
+    }
+    std::string longRecord(100000, 'x');   // longer than a chunk read
+    std::ofstream(fileName.c_str(), std::ios::binary) << longRecord << "\nend\n";
+    ntk::TestDataFile longFile(fileName);
+    ntk::TestDataFile::Reader longReader(longFile, 0);
+    T_CHECK(longReader.next());
+    T_CHECK_EQUAL(longReader.parameter().str(), longRecord);
+    T_CHECK(longReader.next());
+    T_CHECK_EQUAL(longReader.name() + ":" + longReader.parameter().str(), "100001:end");
+    T_CHECK(!longReader.next());
+    std::remove(fileName.c_str());
+    T_CHECK_EQUAL(file.batchCount(), 6u);
+    T_CHECK_EQUAL(cases.size(), 4u);
+    T_CHECK_EQUAL(cases[0], "0:first");
+    T_CHECK_EQUAL(cases[1], "6:");
+    T_CHECK_EQUAL(cases[2], "7:third line");
+    T_CHECK_EQUAL(cases[3], "18:last");
+}
+
+// -- Test asynchronous reporting ----------------------------
+
+#ifndef DO_NOT_USE_THREADS
+
+SUBSUITE(NTK_Unit, Reporting);
+
+TEST(AsyncResult) {
+    ntk::TestResult forwarded;
+    ntk::AsyncTestResult async(forwarded, 4);   // a small queue, so results are also pushed while it is full
+    for (int i = 0; i < 100; ++i) {
+        async.testBegins(this);
+        async.addFailure(ntk::TestFailure("forwarded failure", name(), __FILE__, __LINE__));
+        async.testEnds(this);
+    }
+    T_CHECK_EQUAL(async.failures(), 100);
+    async.drain();
+    T_CHECK_EQUAL(forwarded.failures(), 100);
+    T_CHECK_EQUAL(forwarded.timings().size(), 100u);
+    T_CHECK_EQUAL(forwarded.timings().back().path(), std::string(name()));
+}
+
+#endif
+
+// -- Test selection from changed files ---------------------
+
+SUBSUITE(NTK_Unit, Selection);
+
+TEST(ChangedFiles) {
+    std::string changedFileName = temporaryPath("ntk_unit_changed_files.tmp");
+    std::string dependenciesFileName = temporaryPath("ntk_unit_dependencies.tmp");
+    std::ofstream(changedFileName.c_str()) << "src/other.cpp\n./include/test.hpp\n";
+    std::ofstream(dependenciesFileName.c_str()) << "test_example.o: test_example.cpp \\\n  test.hpp\nother.o: other.cpp\n";
+    ntk::TestOptions options;
+    options.changedFilesFile = changedFileName;
+    ntk::TestFilter changesOnly(ntk::Test::registeredTests(), options);
+    options.dependenciesFile = dependenciesFileName;
+    ntk::TestFilter changesWithDependencies(ntk::Test::registeredTests(), options);
+    std::remove(changedFileName.c_str());
+    std::remove(dependenciesFileName.c_str());
+    T_CHECK(!changesOnly.isSelected(this));
+    T_CHECK(changesWithDependencies.isSelected(this));
+    T_CHECK(ntk::TestChanges::isSameFile("/home/user/project/src/test.cpp", "src/test.cpp"));
+    T_CHECK(!ntk::TestChanges::isSameFile("src/my_test.cpp", "test.cpp"));
+}
+
+TEST(FailedFirstOrder) {
+    ntk::TestSuite suite("Suite", ntk::TestType::TestSuite, false);
+    ntk::TestSuite passed("Passed", ntk::TestType::TestSuite, false);
+    ntk::TestSuite failed("Failed", ntk::TestType::TestSuite, false);
+    ntk::TestSuite failedCase("FailedCase", ntk::TestType::TestSuite, false);
+    ntk::TestSuite otherCase("OtherCase", ntk::TestType::TestSuite, false);
+    failed.addTest(&otherCase);
+    failed.addTest(&failedCase);
+    suite.addTest(&passed);
+    suite.addTest(&failed);
+    std::set<const ntk::Test*> first;
+    first.insert(&failed);
+    first.insert(&failedCase);
+    suite.moveFirst(first);
+    T_CHECK(suite.tests()[0] == &failed);   // the suites are reordered and not run twice
+    T_CHECK(suite.tests()[1] == &passed);
+    T_CHECK(failed.tests()[0] == &failedCase);
+    T_CHECK(failed.tests()[1] == &otherCase);
+}
+
+// -- Test shuffled and repeated runs -----------------------
+
+SUBSUITE(NTK_Unit, Repetitions);
+
+// gets the names of the tests of a suite shuffled with the specified seed
+static std::vector<std::string> shuffledNames(size_t count, unsigned int seed) {
+    std::vector<std::unique_ptr<ntk::TestSuite> > tests;
+    std::vector<ntk::Test*> order;
+    for (size_t i = 0; i < count; ++i) {
+        tests.push_back(std::unique_ptr<ntk::TestSuite>(new ntk::TestSuite(std::string(1, (char)('a' + i)), ntk::TestType::TestSuite, false)));
+        order.push_back(tests.back().get());
+    }
+    std::mt19937 random(seed);
+    ntk::TestSuite::shuffle(order, random);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < order.size(); ++i)
+        names.push_back(order[i]->name());
+    return names;
+}
+
+// gets the number of repetitions run with the specified arguments, the tests failing from the specified repetition
+static unsigned int repetitions(const std::vector<const char*>& arguments, unsigned int failingRepetition) {
+    std::vector<char*> argv(1, const_cast<char*>("test"));
+    for (size_t i = 0; i < arguments.size(); ++i)
+        argv.push_back(const_cast<char*>(arguments[i]));
+    ntk::TestOptions options;
+    options.parse((int)argv.size(), argv.data());
+    unsigned int repetition = 0;
+    while (options.repeatsAfter(repetition, repetition >= failingRepetition) && (repetition < 1000))
+        ++repetition;
+    return repetition + 1;
+}
+
+TEST(ShuffledOrder) {
+    std::vector<std::string> order = shuffledNames(20, 42);
+    T_CHECK(shuffledNames(20, 42) == order);    // the same seed gives the same order
+    T_CHECK(shuffledNames(20, 43) != order);
+    std::sort(order.begin(), order.end());
+    for (size_t i = 0; i < order.size(); ++i)
+        T_CHECK_EQUAL(order[i], std::string(1, (char)('a' + i)));   // no test is lost
+}
+
+TEST(RepeatedRuns) {
+    std::vector<const char*> arguments;
+    T_CHECK_EQUAL(repetitions(arguments, 1000), 1u);
+    arguments.push_back("--repeat=3");
+    T_CHECK_EQUAL(repetitions(arguments, 1000), 3u);
+    T_CHECK_EQUAL(repetitions(arguments, 1), 3u);   // failures do not stop the repetitions
+    arguments.push_back("--until-fail");
+    T_CHECK_EQUAL(repetitions(arguments, 1), 2u);
+    T_CHECK_EQUAL(repetitions(arguments, 1000), 3u);
+    arguments.erase(arguments.begin());
+    T_CHECK_EQUAL(repetitions(arguments, 4), 5u);   // no limit until a test fails
+}
+
+// -- Test suites declared by path --------------------------
+
+SUITE_PATH("NTK_Unit/Assertions");  // adds the following tests to an existing suite
+
+TEST(SuitePath) {
+    T_CHECK_EQUAL(ntk::Test::pathOf(this), std::string("NTK_Unit/Assertions/SuitePath"));
+}
+
+TEST(TestTypes) {
+    T_CHECK(type() == ntk::TestType::TestCase);
+    T_CHECK_EQUAL(std::string(type().name()), std::string("TestCase"));
+    ntk::TestType custom = ntk::TestType::named("CustomTest");
+    T_CHECK(custom == ntk::TestType::named("CustomTest"));  // types declared by name are interned
+    T_CHECK(custom != ntk::TestType::Benchmark);
+    T_CHECK_EQUAL(std::string(custom.name()), std::string("CustomTest"));
+}
+
+TEST(TestNames) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "case%d", 0);
+    ntk::TestSuite copied(buffer, ntk::TestType::TestSuite, false);
+    std::snprintf(buffer, sizeof(buffer), "case%d", 1);
+    T_CHECK_EQUAL(std::string(copied.name()), std::string("case0"));    // names are copied unless declared static
+    static const char staticName[] = "static";
+    ntk::TestSuite shared(ntk::Test::StaticName(staticName), ntk::TestType::TestSuite, false);
+    T_CHECK(shared.name() == staticName);
+}
+
 // -- Test unhandled exception failures ------------------------
 
 #ifndef DO_NOT_USE_EXCEPTIONS
 
 #include <exception>
 
-SUBSUITE(NTK_Unit, UnhandledExceptions);
+SERIAL_SUBSUITE(NTK_Unit, UnhandledExceptions);    // signals are process-wide, never run these concurrently
 
 TEST(UnhandledStdException) {
     throw std::exception();
@@ -228,15 +731,41 @@ TEST(UnhandledOtherException) {
 TEST(UnhandledSystemException) {
     int* p = 0;
     p[10] = 1;  // bad pointer access
-    
-    // I don't know why, but on some compilers the exception jumps out of the first try/catch block
 }
 
+TEST(UnhandledSystemExceptionWhilePaused) {
+    ntk::TestAllocations::Pause pause;
+    int* p = 0;
+    p[10] = 1;  // bad pointer access, the pause does not end
+}
+
+TEST(AllocationsCountedAfterCrash) {
+    T_CHECK_EQUAL(ntk::TestAllocations::counters().paused, 0);
+}
+
+// the sanitizers handle stack overflows themselves
+#if !defined (__SANITIZE_ADDRESS__) && !defined (__SANITIZE_THREAD__)
+
+static int recurse(volatile char* previous, long depth) {
+    volatile char frame[1024];
+    frame[0] = previous[0] + 1;
+    return (depth == 0) ? 0 : (recurse(frame, depth - 1) + frame[1023]);
+}
+
+TEST(UnhandledStackOverflow) {
+    volatile char start[1] = { 0 };
+    T_CHECK(recurse(start, std::numeric_limits<long>::max()) != 0);
+}
+
+#endif
+
 #endif // DO_NOT_CATCH_SIGNALS
 
 #endif // DO_NOT_USE_EXCEPTIONS
 
 // -- Run all tests ----------------------------------------------
 
+TRACK_ALLOCATIONS();
+
 RUN_TESTS(ntk::OStreamTestResult);
 